@@ -0,0 +1,115 @@
+#ifndef AUTOMORPHISMS_H
+#define AUTOMORPHISMS_H
+
+#include <cstdint>
+
+/** Permutations pi of the basis such that e_i\mapsto \pm e_{pi(i)} is an automorphism of the Lie algebra for a suitable choice of signs.
+
+Permutations are enumerated by backtracking, assigning pi(0), pi(1),... in turn; a partial assignment is abandoned as soon as a structure constant among the
+assigned indices is not mapped to a constant with the same absolute value. For a complete permutation, the signs are determined by a linear system over
+GF(2), which is solved by Gaussian elimination. At most max_elements permutations are generated, so for large groups only a subset is obtained; since
+the subset is only used to identify objects which are equivalent under automorphisms, this is harmless.
+*/
+class PermutationAutomorphisms {
+	using Mask = uint64_t;
+	int n;
+	vector<int> absolute_value;		//absolute_value[(i*n+j)*n+k] identifies |c_ij^k|, with 0 for zero
+	vector<bool> negative;			//negative[(i*n+j)*n+k] is true if c_ij^k is the opposite of the representative of its absolute value
+	vector<pair<int,int>> degrees;	//degrees[i] is the number of nonzero c_ij^k and the number of nonzero c_jk^i
+	vector<vector<int>> elements;
+
+	int index(int i, int j, int k) const {return (i*n+j)*n+k;}
+	bool compatible(const vector<int>& pi, int m) const {
+		for (int i=0;i<=m;++i)
+		for (int j=0;j<=m;++j)
+		for (int k=0;k<=m;++k)
+			if ((i==m || j==m || k==m) && absolute_value[index(i,j,k)]!=absolute_value[index(pi[i],pi[j],pi[k])]) return false;
+		return true;
+	}
+	//true if there are signs s_i such that s_is_js_k c_{pi(i)pi(j)}^{pi(k)}=c_ij^k for all i,j,k
+	bool has_signs(const vector<int>& pi) const {
+		vector<pair<Mask,bool>> rows;		//equations \sum_{i\in mask}x_i=b over GF(2), in echelon form
+		auto reduce=[&rows] (pair<Mask,bool> row) {
+			for (auto& reduced : rows)
+				if (row.first & reduced.first & (~reduced.first+1)) {	//the lowest bit of reduced is its pivot
+					row.first^=reduced.first;
+					row.second^=reduced.second;
+				}
+			return row;
+		};
+		for (int i=0;i<n;++i)
+		for (int j=i+1;j<n;++j)
+		for (int k=0;k<n;++k) {
+			if (!absolute_value[index(i,j,k)]) continue;
+			Mask variables=(Mask{1}<<i)^(Mask{1}<<j)^(Mask{1}<<k);
+			auto row=reduce({variables,negative[index(i,j,k)]!=negative[index(pi[i],pi[j],pi[k])]});
+			if (!row.first) {
+				if (row.second) return false;
+				continue;
+			}
+			Mask pivot=row.first & (~row.first+1);
+			for (auto& reduced : rows)
+				if (reduced.first & pivot) {
+					reduced.first^=row.first;
+					reduced.second^=row.second;
+				}
+			rows.push_back(row);
+		}
+		return true;
+	}
+	void extend(vector<int>& pi, Mask used, int m, int max_elements) {
+		if (elements.size()>=max_elements) return;
+		if (m==n) {
+			if (has_signs(pi)) elements.push_back(pi);
+			return;
+		}
+		for (int t=0;t<n;++t) {
+			if (used & (Mask{1}<<t) || degrees[t]!=degrees[m]) continue;
+			pi[m]=t;
+			if (compatible(pi,m)) extend(pi,used|(Mask{1}<<t),m+1,max_elements);
+		}
+	}
+public:
+	PermutationAutomorphisms(const StructureConstants& c, int max_elements=1000) : n{c.dimension()}, absolute_value(n*n*n), negative(n*n*n), degrees(n) {
+		map<ex,int,ex_is_less> absolute_values;
+		for (int k=0;k<n;++k)
+		for (auto entry=c.begin(k);entry!=c.end(k);++entry) {
+			ex representative=ex_is_less{}(entry->c,-entry->c)? entry->c : -entry->c;
+			auto id=absolute_values.emplace(representative,absolute_values.size()+1).first->second;
+			bool is_negative=entry->c!=representative;
+			absolute_value[index(entry->i,entry->j,k)]=absolute_value[index(entry->j,entry->i,k)]=id;
+			negative[index(entry->i,entry->j,k)]=is_negative;
+			negative[index(entry->j,entry->i,k)]=!is_negative;
+			++degrees[entry->i].first;
+			++degrees[entry->j].first;
+			++degrees[k].second;
+		}
+		vector<int> pi(n);
+		extend(pi,0,0,max_elements);
+	}
+	//the permutations found, starting with the identity
+	const vector<vector<int>>& permutations() const {return elements;}
+};
+
+/** Given a list of involutions of {0,...,n-1} closed under conjugation by the given permutations, return a vector of flags indicating which involutions
+come first in the list among those conjugate to them by a product of the permutations. */
+vector<bool> first_in_orbit(const vector<vector<int>>& involutions, const vector<vector<int>>& permutations) {
+	map<vector<int>,int> index;
+	for (int i=0;i<involutions.size();++i) index[involutions[i]]=i;
+	vector<int> parent(involutions.size());
+	iota(parent.begin(),parent.end(),0);
+	function<int(int)> root=[&parent,&root] (int i) {return parent[i]==i? i : parent[i]=root(parent[i]);};
+	for (auto& pi : permutations)
+	for (int i=0;i<involutions.size();++i) {
+		auto& sigma=involutions[i];
+		vector<int> conjugate(sigma.size());	//pi\sigma\pi^{-1}
+		for (int j=0;j<sigma.size();++j) conjugate[pi[j]]=pi[sigma[j]];
+		auto a=root(i), b=root(index.at(conjugate));
+		if (a!=b) parent[max(a,b)]=min(a,b);
+	}
+	vector<bool> result;
+	for (int i=0;i<involutions.size();++i) result.push_back(root(i)==i);
+	return result;
+}
+
+#endif
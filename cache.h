@@ -0,0 +1,99 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include "fdio.h"
+
+//version of the code computing cached results; change it whenever a change in the code affects the results, so that entries computed by older versions are ignored
+const string ENGINE_VERSION="10";
+
+/** A persistent cache of results on disk, addressed by content.
+
+Each entry is identified by a kind and a key, and stored in a file whose name is a hash of the key, in a subdirectory named after the engine version and
+the kind; the file contains the key on its first line, so that hash collisions are detected. Entries are written atomically, so that the cache can be shared
+by processes running concurrently, possibly on different nodes.
+*/
+class ResultCache {
+	using path = std::filesystem::path;
+	path dir;
+
+	static uint64_t hash(const string& key) {	//FNV-1a
+		uint64_t result=14695981039346656037ull;
+		for (unsigned char c : key) {
+			result^=c;
+			result*=1099511628211ull;
+		}
+		return result;
+	}
+	path file(const string& kind, const string& key) const {
+		stringstream name;
+		name<<std::hex<<std::setw(16)<<std::setfill('0')<<hash(key);
+		return dir/kind/name.str();
+	}
+public:
+	ResultCache(const string& dir) : dir{path{dir}/("engine-"+ENGINE_VERSION)} {}
+	optional<string> get(const string& kind, const string& key) const {
+		std::ifstream is{file(kind,key),std::ios::binary};
+		string stored_key;
+		if (!is || !getline(is,stored_key) || stored_key!=key) return nullopt;
+		stringstream s;
+		s<<is.rdbuf();
+		return s.str();
+	}
+	//keys cannot contain newlines
+	void put(const string& kind, const string& key, const string& value) const {
+		assert(key.find('\n')==string::npos);
+		auto p=file(kind,key);
+		std::filesystem::create_directories(p.parent_path());
+		auto temporary=p;
+		temporary+="."+fdio::host_and_pid()+".tmp";
+		{
+			std::ofstream os{temporary,std::ios::binary};
+			os<<key<<'\n'<<value;
+			if (!os) throw std::runtime_error("cannot write "+temporary.string());
+		}
+		std::filesystem::rename(temporary,p);
+	}
+};
+
+//represent a sequence of linear forms with rational coefficients in the given variables as a string, or return nullopt if the forms are not of this type
+optional<string> linear_forms_to_string(const ExVector& forms, const ExVector& variables) {
+	lst variables_to_zero;
+	for (auto& x: variables) variables_to_zero.append(x==0);
+	stringstream s;
+	for (auto form: forms) {
+		form=form.expand();
+		if (!form.subs(variables_to_zero).is_zero()) return nullopt;
+		for (auto& x: variables) {
+			ex c=form.coeff(x);
+			if (!is_a<numeric>(c) || !ex_to<numeric>(c).is_rational()) return nullopt;
+			s<<ex_to<numeric>(c).numer()<<"/"<<ex_to<numeric>(c).denom()<<" ";
+		}
+		s<<endl;
+	}
+	return s.str();
+}
+
+//inverse of linear_forms_to_string
+ExVector linear_forms_from_string(const string& forms, const ExVector& variables) {
+	ExVector result;
+	stringstream s{forms};
+	string line;
+	while (getline(s,line)) {
+		stringstream coefficients{line};
+		ex form;
+		for (auto& x: variables) {
+			string c;
+			coefficients>>c;
+			auto slash=c.find('/');
+			if (slash==string::npos) throw std::invalid_argument("invalid cache entry: "+line);
+			form+=numeric(c.substr(0,slash).c_str())/numeric(c.substr(slash+1).c_str())*x;
+		}
+		result.push_back(form);
+	}
+	return result;
+}
+
+#endif
@@ -73,16 +73,24 @@ lst symbols() {
 	return symbols;
 }	
 
-class GroupClassification : public Classification<LieGroup> {
+/** Represents a classification of Lie groups, where each Lie group is only constructed when requested, and owned by the caller.
+
+Only the data needed to construct the Lie groups is stored, so that memory usage does not depend on the Lie groups constructed so far, and the first Lie group
+is available without constructing the others.
+*/
+class GroupClassification {
+	vector<function<unique_ptr<LieGroup>()>> constructors;
 protected:
-	using Classification<LieGroup>::add;
 	void add(const char* structure_constants) {
-		Classification<LieGroup>::add(make_unique<AbstractLieGroup<false>>	(structure_constants));
+		string s{structure_constants};
+		constructors.push_back([s] () -> unique_ptr<LieGroup> {return make_unique<AbstractLieGroup<false>>(s.c_str());});
 	}
 	template <typename... T>
 	void add(const char* structure_constants, const T&... names) {
-		Classification<LieGroup>::add(make_unique<AbstractLieGroup<true>>	(structure_constants, names...));
+		string s{structure_constants};
+		constructors.push_back([s,names...] () -> unique_ptr<LieGroup> {return make_unique<AbstractLieGroup<true>>(s.c_str(),names...);});
 	}
+	GroupClassification() {}
 public:
 	static GroupClassification from_disk(const string& filename) {
 		std::filesystem::path p{filename};		
@@ -97,10 +105,13 @@ public:
 		GroupClassification result;
 		string line;
 		while (std::getline(is,line)) {						
-			result.add(make_unique<AbstractLieGroup<true>>(line.c_str(),symbols()));
+			result.constructors.push_back([line] () -> unique_ptr<LieGroup> {return make_unique<AbstractLieGroup<true>>(line.c_str(),symbols());});
 		}
 		return result;
 	}
+	int size() const {return constructors.size();}
+	//construct the Lie group with the given zero-based index
+	unique_ptr<LieGroup> construct(int index) const {return constructors[index]();}
 };
 
 GroupClassification nilpotent_lie_groups_3() {
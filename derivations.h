@@ -23,6 +23,8 @@ using namespace GiNaC;
 using namespace std;
 using namespace Wedge;
 
+#include "structureconstants.h"
+
 ex Xbracket(const LieGroup& G, const GLRepresentation<VectorField>& V, ex A, ex X, ex Y) {
 	ex Ax=V.Action<VectorField>(A,X);
 	ex Ay=V.Action<VectorField>(A,Y);
@@ -45,29 +47,6 @@ struct VectorSpaceBetween {
 	exvector basis_of_larger_space;
 };
 
-/** For a Lie group with parameters, return a VectorSpaceBetween object representing the derivations
-	@param G a Lie group of dimension n, with or without parameters
-	@param Gl The Lie algebra of GL(n,R), acting on the Lie algebra of g through the identification g=R^n given by the standard coframe of g
-	@result A VectorSpaceBetween representing the subspace of Gl corresponding to the space of derivations
-	
-	The exact space of derivations corresponds to solutions of a linear system depending on parameters. This function computes the space of solutions of a subset of the equations that do not depend on a parameter and the space of elements that satisfy the equations for all values of the parameters
-*/	
-
-template<typename Parameter>
-VectorSpaceBetween derivations_parametric(const LieGroup& G,const GL& Gl)  {
-		auto gl=Gl.pForms(1);
-		auto generic_matrix =gl.GenericElement();
-		auto X=Xbrackets(G,GLRepresentation<VectorField>(&Gl,G.e()),generic_matrix);
-		lst eqns,sol;
-		GetCoefficients<VectorField>(eqns,X);
-		Wedge::linear_impl::LinearEquationsWithParameters<VectorSpace<DifferentialForm>::Coordinate,Parameter> linear_eqns{eqns,lst{gl.coordinate_begin(),gl.coordinate_end()}};
-		linear_eqns.eliminate_linear_equations();
-		VectorSpaceBetween result;
-		gl.GetSolutionsFromGenericSolution(result.basis_of_larger_space,linear_eqns.solution());
-		gl.GetSolutionsFromGenericSolution(result.basis_of_smaller_space,linear_eqns.always_solution());
-		return result;
-}
-
 //a diagonal matrix (d)_ij is a derivation if d[e_i,e_j]=[de_i,e_j]+[e_i,de_j] i.e. 
 
 template<typename T> ExVector vector_of_symbols(int size, const Name& n) {
@@ -77,22 +56,13 @@ template<typename T> ExVector vector_of_symbols(int size, const Name& n) {
 	return result;
 }
 
-//given a nice Lie group G and an index k, return the sequence of pairs (i,j) such that [e_i,e_j] is a nonzero multiple of e_k or nullopt
-vector<pair<int,int>> nodes_going_to(const LieGroup& G, OneBased k) {
+//given the structure constants of a nice Lie group and a one-based index k, return the sequence of pairs (i,j) such that [e_i,e_j] is a nonzero multiple of e_k
+vector<pair<int,int>> nodes_going_to(const StructureConstants& c, int k) {
 	vector<pair<int,int>> result;
-	ex de_k=G.d(G.e(k));
-	if (de_k.is_zero()) return result;
-	int n=G.Dimension();
-	for (int i=1;i<=n;++i) {
-		ex e_i_hook_de_k=Hook(G.e(i),de_k);
-		if (!e_i_hook_de_k.is_zero())
-			for (int j=i+1;j<=n;++j) {
-				if (!TrivialPairing<DifferentialForm>(G.e(j),e_i_hook_de_k).is_zero()) {
-					result.push_back(make_pair(i,j));
-					break;
-				}
-			}
-	}	
+	int n=c.dimension();
+	for (int i=0;i<n;++i)
+		if (auto j=c.adjacent_to(i,k-1) & StructureConstants::above(i))
+			result.push_back(make_pair(i+1,__builtin_ctzll(j)+1));
 	return result;	
 }
 
@@ -102,14 +72,225 @@ ex equation(const ExVector& D, int i, int j, int k) {
 }
 
 WEDGE_DECLARE_NAMED_ALGEBRAIC(DerivationParameter, realsymbol)
-ExVector diagonal_derivations_on_nice_lie_algebra(const LieGroup& G) {	
-	int n=G.Dimension();
-	auto diagonal_derivation=vector_of_symbols<DerivationParameter>(n,N.lambda);
+ExVector diagonal_derivation_parameters(int n) {
+	return vector_of_symbols<DerivationParameter>(n,N.lambda);
+}
+
+//return the diagonal derivations of a nice Lie group with structure constants c, expressed in terms of the parameters of a generic diagonal matrix
+ExVector diagonal_derivations_on_nice_lie_algebra(const StructureConstants& c, ExVector diagonal_derivation) {	
+	int n=c.dimension();
+	assert(diagonal_derivation.size()==n);
 	lst eqns;
 	for (int k=1;k<=n;++k) 
-		for (auto ij :nodes_going_to(G,k))
+		for (auto ij :nodes_going_to(c,k))
 		 	eqns.append(equation(diagonal_derivation,ij.first, ij.second, k));	
 	auto sol=lsolve(eqns,lst{diagonal_derivation.begin(),diagonal_derivation.end()});
 	for (ex& x: diagonal_derivation ) x=x.subs(sol);
 	return diagonal_derivation;	
 }
+
+ExVector diagonal_derivations_on_nice_lie_algebra(const StructureConstants& c) {	
+	return diagonal_derivations_on_nice_lie_algebra(c,diagonal_derivation_parameters(c.dimension()));
+}
+
+//return the weights of a generic diagonal derivation, expressed in terms of the parameters of a generic diagonal matrix; unlike diagonal_derivations_on_nice_lie_algebra, the basis need not be nice
+ExVector diagonal_weights(const StructureConstants& c) {
+	auto diagonal_derivation=diagonal_derivation_parameters(c.dimension());
+	lst eqns;
+	for (int k=0;k<c.dimension();++k)
+	for (auto entry=c.begin(k);entry!=c.end(k);++entry)
+		eqns.append(equation(diagonal_derivation,entry->i+1,entry->j+1,k+1));
+	auto sol=lsolve(eqns,lst{diagonal_derivation.begin(),diagonal_derivation.end()});
+	for (ex& x: diagonal_derivation) x=x.subs(sol);
+	return diagonal_derivation;
+}
+
+//a row of a sparse matrix, mapping the index of each column to the nonzero entry in that column
+using SparseRow = map<int,numeric>;
+
+//divide a row with integer entries by the gcd of its entries
+void make_primitive(SparseRow& row) {
+	numeric divisor;
+	for (auto& entry: row) divisor=gcd(divisor,entry.second);
+	if (divisor!=0 && divisor!=1)
+		for (auto& entry: row) entry.second/=divisor;
+}
+
+//replace row with a*row-b*pivot_row, where a and b are chosen so that the entry in the column of the leading entry of pivot_row becomes zero
+void eliminate(SparseRow& row, const SparseRow& pivot_row, int column) {
+	auto b=row.find(column);
+	if (b==row.end()) return;
+	numeric a=pivot_row.at(column), b_=b->second;
+	for (auto& entry: row) entry.second*=a;
+	for (auto& entry: pivot_row) {
+		auto& x=row[entry.first];
+		x-=b_*entry.second;
+		if (x.is_zero()) row.erase(entry.first);
+	}
+	make_primitive(row);
+}
+
+/** Compute a basis of the space of solutions of a homogeneous linear system with rational coefficients by fraction-free sparse elimination.
+
+Each row is scaled to have integer entries, and elimination replaces a row r with ar-bp, where p is a pivot row, dividing by the gcd of the entries, so that
+no fractions appear. The system is brought to reduced echelon form, with pivots in the leftmost possible columns; for each nonpivot column, the basis contains
+the solution where the corresponding unknown equals one and the other nonpivot unknowns are zero. This is the basis obtained by solving the system for the
+unknowns in order, as done by lsolve.
+@param rows The equations, involving only the unknowns in columns
+@param columns The indices of the unknowns, in increasing order
+@return The basis of solutions, indexed by the corresponding nonpivot column
+*/
+map<int,SparseRow> kernel(vector<SparseRow> rows, const vector<int>& columns) {
+	map<int,SparseRow> pivot_rows;		//indexed by the column of the leading entry
+	for (auto& row: rows) {
+		numeric denominator=1;
+		for (auto& entry: row) denominator=lcm(denominator,entry.second.denom());
+		for (auto& entry: row) entry.second*=denominator;
+		make_primitive(row);
+		while (!row.empty()) {
+			int column=row.begin()->first;
+			auto pivot_row=pivot_rows.find(column);
+			if (pivot_row==pivot_rows.end()) {
+				pivot_rows.emplace(column,move(row));
+				break;
+			}
+			eliminate(row,pivot_row->second,column);
+		}
+	}
+	//proceeding from the right, the pivot row is already reduced relative to the pivots on its right, so elimination does not introduce nonzero entries there
+	for (auto pivot_row=pivot_rows.rbegin();pivot_row!=pivot_rows.rend();++pivot_row)
+		for (auto& row: pivot_rows)
+			if (row.first<pivot_row->first) eliminate(row.second,pivot_row->second,pivot_row->first);
+	map<int,SparseRow> result;
+	for (int free: columns) {
+		if (pivot_rows.count(free)) continue;
+		SparseRow solution{{free,1}};
+		for (auto& row: pivot_rows) {
+			auto x=row.second.find(free);
+			if (x!=row.second.end()) solution[row.first]=-x->second/row.second.at(row.first);
+		}
+		result.emplace(free,move(solution));
+	}
+	return result;
+}
+
+/** Compute a basis of the space of solutions of a homogeneous linear system which is block diagonal, solving the system corresponding to each block separately.
+@param rows The equations; each equation can only involve unknowns in the same block
+@param block The block containing each unknown
+@return The same basis as returned by kernel for the whole system
+*/
+vector<SparseRow> kernel_by_blocks(const vector<SparseRow>& rows, const vector<int>& block) {
+	int blocks=block.empty()? 0 : *max_element(block.begin(),block.end())+1;
+	vector<vector<int>> columns(blocks);
+	for (int s=0;s<block.size();++s) columns[block[s]].push_back(s);
+	vector<vector<SparseRow>> rows_in_block(blocks);
+	for (auto& row: rows) {
+		assert(all_of(row.begin(),row.end(),[&block,&row] (auto& entry) {return block[entry.first]==block[row.begin()->first];}));
+		rows_in_block[block[row.begin()->first]].push_back(row);
+	}
+	map<int,SparseRow> solutions;
+	for (int b=0;b<blocks;++b) solutions.merge(kernel(move(rows_in_block[b]),columns[b]));
+	vector<SparseRow> result;
+	for (auto& solution: solutions) result.push_back(move(solution.second));
+	return result;
+}
+
+/** Return the derivations of a Lie group whose structure constants are rational, or nullopt if the structure constants are of a different type
+	@param G a Lie group of dimension n
+	@param c The structure constants of G
+	@param Gl The Lie algebra of GL(n,R), acting on the Lie algebra of g through the identification g=R^n given by the standard coframe of g
+
+	The linear system defining derivations is assembled directly from the structure constants and the action of the basis of gl, and solved by sparse
+	elimination in exact arithmetic. The basis obtained is the same as by solving the system symbolically. Relative to the diagonal derivations, gl splits into
+	weight spaces; if the basis of gl consists of weight vectors, the system is block diagonal, and the system for each weight is solved separately.
+*/
+optional<exvector> derivations_with_rational_structure_constants(const LieGroup& G, const StructureConstants& c, const GL& Gl) {
+	int n=c.dimension();
+	vector<numeric> bracket(n*n*n);	//bracket[(i*n+j)*n+k] is c_ij^k, with c_ji^k=-c_ij^k
+	auto rational=[] (ex x) {return is_a<numeric>(x) && ex_to<numeric>(x).is_rational();};
+	for (int k=0;k<n;++k)
+	for (auto entry=c.begin(k);entry!=c.end(k);++entry) {
+		if (!rational(entry->c)) return nullopt;
+		bracket[(entry->i*n+entry->j)*n+k]=ex_to<numeric>(entry->c);
+		bracket[(entry->j*n+entry->i)*n+k]=-ex_to<numeric>(entry->c);
+	}
+	auto C=[&bracket,n] (int i, int j, int k) {return bracket[(i*n+j)*n+k];};
+	//the basis element s of gl maps e_k to \sum_l a e_l for each (l,k,a) in action[s]
+	struct Entry {int l,k; numeric a;};
+	auto gl=Gl.pForms(1);
+	GLRepresentation<VectorField> V(&Gl,G.e());
+	vector<vector<Entry>> action(gl.Dimension());
+	for (int s=0;s<gl.Dimension();++s)
+	for (int k=0;k<n;++k) {
+		ex image=V.Action<VectorField>(gl.e()[s],G.e()[k]).expand();
+		for (int l=0;l<n;++l) {
+			ex a=image.coeff(G.e()[l]);
+			if (!rational(a)) return nullopt;
+			if (!a.is_zero()) action[s].push_back(Entry{l,k,ex_to<numeric>(a)});
+		}
+	}
+	//the component along e_m of D[e_i,e_j]-[De_i,e_j]-[e_i,De_j], where D=\sum_s x_s e_s
+	vector<SparseRow> equations;
+	for (int i=0;i<n;++i)
+	for (int j=i+1;j<n;++j)
+	for (int m=0;m<n;++m) {
+		SparseRow equation;
+		for (int s=0;s<gl.Dimension();++s) {
+			numeric x;
+			for (auto& entry: action[s]) {
+				if (entry.l==m) x+=entry.a*C(i,j,entry.k);
+				if (entry.k==i) x-=entry.a*C(entry.l,j,m);
+				if (entry.k==j) x-=entry.a*C(i,entry.l,m);
+			}
+			if (!x.is_zero()) equation[s]=x;
+		}
+		if (!equation.empty()) equations.push_back(move(equation));
+	}
+	//the weight of e_s is w_l-w_k for each (l,k,a) in action[s]; the unknowns of each equation have the same weight if the e_s are weight vectors
+	auto weights=diagonal_weights(c);
+	map<ex,int,ex_is_less> weight_index;
+	vector<int> block;
+	for (auto& entries: action) {
+		ex weight=entries.empty()? 0 : (weights[entries[0].l]-weights[entries[0].k]).expand();
+		for (auto& entry: entries)
+			if (!(weights[entry.l]-weights[entry.k]-weight).expand().is_zero()) weight=lst{};	//not a weight vector
+		block.push_back(weight_index.emplace(weight,weight_index.size()).first->second);
+	}
+	bool block_diagonal=all_of(equations.begin(),equations.end(),[&block] (const SparseRow& equation) {
+		return all_of(equation.begin(),equation.end(),[&block,&equation] (auto& entry) {return block[entry.first]==block[equation.begin()->first];});
+	});
+	if (!block_diagonal) fill(block.begin(),block.end(),0);
+	exvector result;
+	for (auto& solution: kernel_by_blocks(equations,block)) {
+		ex derivation;
+		for (auto& x: solution) derivation+=x.second*gl.e()[x.first];
+		result.push_back(derivation);
+	}
+	return result;
+}
+
+/** For a Lie group with parameters, return a VectorSpaceBetween object representing the derivations
+	@param G a Lie group of dimension n, with or without parameters
+	@param c The structure constants of G
+	@param Gl The Lie algebra of GL(n,R), acting on the Lie algebra of g through the identification g=R^n given by the standard coframe of g
+	@result A VectorSpaceBetween representing the subspace of Gl corresponding to the space of derivations
+	
+	The exact space of derivations corresponds to solutions of a linear system depending on parameters. This function computes the space of solutions of a subset of the equations that do not depend on a parameter and the space of elements that satisfy the equations for all values of the parameters.
+	If the structure constants are rational, the two spaces coincide and are computed by sparse elimination; otherwise, the system is solved symbolically.
+*/
+
+template<typename Parameter>
+VectorSpaceBetween derivations_parametric(const LieGroup& G, const StructureConstants& c, const GL& Gl)  {
+		if (auto derivations=derivations_with_rational_structure_constants(G,c,Gl)) return {derivations.value(),derivations.value()};
+		auto gl=Gl.pForms(1);
+		auto generic_matrix =gl.GenericElement();
+		auto X=Xbrackets(G,GLRepresentation<VectorField>(&Gl,G.e()),generic_matrix);
+		lst eqns,sol;
+		GetCoefficients<VectorField>(eqns,X);
+		Wedge::linear_impl::LinearEquationsWithParameters<VectorSpace<DifferentialForm>::Coordinate,Parameter> linear_eqns{eqns,lst{gl.coordinate_begin(),gl.coordinate_end()}};
+		linear_eqns.eliminate_linear_equations();
+		VectorSpaceBetween result;
+		gl.GetSolutionsFromGenericSolution(result.basis_of_larger_space,linear_eqns.solution());
+		gl.GetSolutionsFromGenericSolution(result.basis_of_smaller_space,linear_eqns.always_solution());
+		return result;
+}
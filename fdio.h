@@ -0,0 +1,49 @@
+#ifndef FDIO_H
+#define FDIO_H
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+//helpers to transfer whole buffers through file descriptors, and to name files written by concurrent processes
+namespace fdio {
+
+void write_fully(int fd, const void* data, size_t size) {
+	auto p=static_cast<const char*>(data);
+	while (size) {
+		auto written=write(fd,p,size);
+		if (written<0) {
+			if (errno==EINTR) continue;
+			throw std::runtime_error(string("write failed: ")+strerror(errno));
+		}
+		p+=written;
+		size-=written;
+	}
+}
+
+//return false if end of file is reached before size bytes are read
+bool read_fully(int fd, void* data, size_t size) {
+	auto p=static_cast<char*>(data);
+	while (size) {
+		auto n=read(fd,p,size);
+		if (n<0) {
+			if (errno==EINTR) continue;
+			throw std::runtime_error(string("read failed: ")+strerror(errno));
+		}
+		if (n==0) return false;
+		p+=n;
+		size-=n;
+	}
+	return true;
+}
+
+//a string identifying the current process among processes running on different hosts
+string host_and_pid() {
+	char host[256]={};
+	gethostname(host,sizeof(host)-1);
+	return string(host)+"-"+to_string(getpid());
+}
+
+}
+
+#endif
@@ -2,24 +2,50 @@ WEDGE_DECLARE_NAMED_ALGEBRAIC(WParameter,realsymbol)
  
  //a basis obtained from G.e() by reordering, in such a way that e_i\hook de^j\neq 0 implies i<j and [e(i_hat),e(i)] is in the span of e_n
 class OrderedBasis {
-    LinearExtension<int> ordered_basis;
     const LieGroup& G;
-    static LinearExtension<int> first_compatible_order(const LieGroup& G) {
+    const StructureConstants& structure_constants;
+    LinearExtension<int> ordered_basis;
+    static LinearExtension<int> first_compatible_order(const StructureConstants& c) {
         vector<int> indices; 
         set<pair<int,int>> poset;
-        indices.resize(G.Dimension());
+        indices.resize(c.dimension());
         iota(indices.begin(),indices.end(),0);
-        for (int i=0;i<G.Dimension();++i)
-        for (int j=0;j<G.Dimension();++j)
-            if (!Hook(G.e()[i],G.d(G.e()[j])).is_zero()) poset.emplace(i,j);
-        return LinearExtension<int>::begin(indices,poset);
+        for (int i=0;i<c.dimension();++i)
+        for (int j=0;j<c.dimension();++j)
+            if (c.hook_nonzero(i,j)) poset.emplace(i,j);
+        return LinearExtension<int>::begin(indices,poset,admissible_prefix(c));
+    }
+    //return c if [e_a,e_b] is a nonzero multiple of e_c, -1 if it is zero, -2 otherwise
+    static int multiple_of(const StructureConstants& c, int a, int b) {
+        auto components=c.components(a,b);
+        if (!components) return -1;
+        if (components & (components-1)) return -2;
+        return __builtin_ctzll(components);
+    }
+    //a function which returns false on prefixes that cannot be extended to a basis such that [e(i_hat),e(i)] is in the span of e_n for all i
+    static function<bool(const vector<int>&)> admissible_prefix(const StructureConstants& c) {
+        int n=c.dimension();
+        vector<vector<int>> multiple(n,vector<int>(n));
+        for (int a=0;a<n;++a)
+        for (int b=0;b<n;++b)
+            multiple[a][b]=multiple_of(c,a,b);
+        return [n,multiple] (const vector<int>& prefix) {
+            int last=-1;  //the element e_n must be, if determined
+            for (int i=0;i<prefix.size();++i) {
+                int ihat=n-i-1;
+                if (ihat<=i || ihat>=prefix.size()) continue;
+                int c=multiple[prefix[i]][prefix[ihat]];
+                if (c==-2 || (c>=0 && last>=0 && c!=last)) return false;
+                if (c>=0) last=c;
+            }
+            if (last<0) return true;
+            auto position=find(prefix.begin(),prefix.end(),last)-prefix.begin();
+            return position==prefix.size() || position==n-1;
+        };
     }
     bool bracket_in_span_of_last(int i, int j) const {
-        auto sigma=*ordered_basis;
-        ex e_sigma_i=G.e()[sigma[i]];
-        ex e_sigma_j=G.e()[sigma[j]];        
-        ex e_n=G.e()[sigma.back()];
-        return (G.LieBracket(e_sigma_i,e_sigma_j).subs(e_n==0)).expand().is_zero();
+        auto& sigma=*ordered_basis;
+        return !(structure_constants.components(sigma[i],sigma[j]) & ~StructureConstants::bit(sigma.back()));
     }
     bool is_valid() const {
         for (int i=0;i<G.Dimension();++i)
@@ -31,7 +57,7 @@ class OrderedBasis {
     }
 
 public:
-    OrderedBasis(const LieGroup& G) : ordered_basis{first_compatible_order(G)}, G{G} {
+    OrderedBasis(const LieGroup& G, const StructureConstants& structure_constants) : G{G}, structure_constants{structure_constants}, ordered_basis{first_compatible_order(structure_constants)} {
         advance_until_valid();
     }
     int hat(int i) const {
@@ -41,6 +67,12 @@ public:
         while (++ordered_basis && !is_valid()) {};
         return *this;
     } 
+    //skip the remaining ordered bases starting with the first length elements of the current one
+    OrderedBasis& advance_past_prefix(int length) {
+        ordered_basis.advance_past_prefix(length);
+        advance_until_valid();
+        return *this;
+    }
     exvector e() const {
         exvector e;
         std::transform(ordered_basis->begin(),ordered_basis->end(),back_inserter(e), [this] (int i) {return G.e()[i];} );
@@ -48,14 +80,24 @@ public:
     }
     operator bool() const {return ordered_basis;}
     vector<int> indices() const {return *ordered_basis;}
+    const StructureConstants& constants() const {return structure_constants;}
 };
 
 
+/** Iterates through the ordered bases that admit a filtration satisfying (F1)--(F5), computing the weights.
+
+The inequalities are split into a part that does not depend on the ordered basis, built once, and the inequalities w_k>=w_i+w_j coming from brackets,
+which only depend on the elements of the ordered basis in positions i, j, k. The latter are kept in a stack indexed by the length of the prefix of the
+ordered basis they depend on, so that moving to the next ordered basis only recomputes the inequalities of the positions that have changed; if the
+inequalities that depend on a prefix have no solution, all the ordered bases with that prefix are skipped.
+*/
 class Filtration {
     const LieGroup& G;
     OrderedBasis ordered_basis;    
     exvector w;    
-    AlternativeLinearInequalities<WParameter> inequalities; 
+    AlternativeLinearInequalities<WParameter> inequalities_independent_of_order;
+    vector<int> indices_of_constraints; //the ordered basis the elements of constraints_on_prefix refer to
+    vector<LinearInequalities<WParameter>> constraints_on_prefix;  //constraints_on_prefix[l] contains the inequalities depending on the first l elements of the ordered basis
     lst weights_;
 /*
     AlternativeLinearInequalities<WParameter>(int i) const {
@@ -95,43 +137,53 @@ class Filtration {
         return result;
     }
 
-    AlternativeLinearInequalities<WParameter> inequalities_for_good_filtration() const {
-        auto alt=inequalities_for_positive_filtration();    //filtration satisfying F1        
-        exvector inequalities{}, strict_inequalities;
+    //the inequalities that do not depend on the ordered basis, except those for F3 and F4 
+    LinearInequalities<WParameter> inequalities_independent_of_brackets() const {
+        exvector inequalities{}, strict_inequalities{w[0]};
+        for (int i=1;i<w.size();++i)                   //F1
+            inequalities.push_back(w[i]-w[i-1]);
         for (int i=0;i<(w.size()+1)/2;++i) {           //F2
             inequalities.push_back(w[i]+w[ordered_basis.hat(i)]-w.back());        
             strict_inequalities.push_back(w[i]+w[ordered_basis.hat(i)]-w[w.size()-2]);
         }
-        alt=alt &&  LinearInequalities<WParameter>{}.nonnegative(inequalities.begin(),inequalities.end()).positive(strict_inequalities.begin(),strict_inequalities.end());
+        return LinearInequalities<WParameter>{}.nonnegative(inequalities.begin(),inequalities.end()).positive(strict_inequalities.begin(),strict_inequalities.end());
+    }
+    AlternativeLinearInequalities<WParameter> inequalities_for_F3_and_F4() const {
+        AlternativeLinearInequalities<WParameter> alt{LinearInequalities<WParameter>{}};
         for (int i=0;i<(w.size())/2;++i)            //F3 and F4 for i!=ihat
             alt = alt &&inequalities_for_indices(i,ordered_basis.hat(i));        
-        return alt;            
-    }
-
-
-    AlternativeLinearInequalities<WParameter> inequalities_for_positive_filtration() const {
-        if (!ordered_basis) return {};
-        exvector inequalities;        
-        auto e=basis();       
-        for (int i=1;i<e.size();++i)
-            inequalities.push_back(w[i]-w[i-1]);        
-        
-        for (int i=0;i<G.Dimension();++i)
-        for (int j=i+1;j<G.Dimension();++j)
-        for (int k=0;k<G.Dimension();++k)
-            if (!Hook(e[i]*e[j],G.d(e[k])).is_zero())
+        return alt;
+    }
+    //the inequalities of F1 determined by brackets [e_i,e_j] whose component along e_k is nonzero, where max(i,j,k)=m
+    list<ex> inequalities_for_brackets(const vector<int>& indices, int m) const {
+        list<ex> inequalities;
+        auto& c=ordered_basis.constants();
+        for (int i=0;i<=m;++i)
+        for (int j=i+1;j<=m;++j)
+        for (int k= j==m? 0 : m;k<=m;++k)
+            if (c.bracket_nonzero(indices[i],indices[j],indices[k]))
                 inequalities.push_back(w[k]-w[i]-w[j]);
-        return AlternativeLinearInequalities<WParameter>::positive(w[0]) &&        
-            LinearInequalities<WParameter>{}.nonnegative(inequalities.begin(),inequalities.end());
-    }
-    void advance() {        
-        if (++ordered_basis)
-            inequalities=inequalities_for_good_filtration();
+        return inequalities;
+    }
+    //bring constraints_on_prefix up to date with the current ordered basis; return the length of a prefix whose inequalities have no solution, if any
+    optional<int> update_constraints() {
+        auto indices=ordered_basis.indices();
+        int unchanged=mismatch(indices.begin(),indices.end(),indices_of_constraints.begin(),indices_of_constraints.end()).first-indices.begin();
+        constraints_on_prefix.resize(min<int>(constraints_on_prefix.size(),unchanged+1));
+        indices_of_constraints=indices;
+        for (int length=constraints_on_prefix.size();length<=indices.size();++length) {
+            constraints_on_prefix.push_back(constraints_on_prefix.back().nonnegative(inequalities_for_brackets(indices,length-1)));
+            if (!constraints_on_prefix.back().has_solution()) return length;
+        }
+        return nullopt;
     }
     void advance_until_valid() {
         weights_=lst{};
-        while (ordered_basis && (weights_=inequalities.find_solution()).nops()==0)
-            advance();
+        while (ordered_basis) {
+            if (auto length=update_constraints()) ordered_basis.advance_past_prefix(length.value());
+            else if ((weights_=(AlternativeLinearInequalities<WParameter>{constraints_on_prefix.back()} && inequalities_independent_of_order).find_solution()).nops()) return;
+            else ++ordered_basis;
+        }
     }
     static exvector create_parameters(int n) {
         exvector w;
@@ -139,12 +191,14 @@ class Filtration {
         return w;
     }
 public:
-    Filtration(const LieGroup& G) : G{G}, ordered_basis{G}, w{create_parameters(G.Dimension())}, inequalities{inequalities_for_good_filtration()} {              
+    Filtration(const LieGroup& G, const StructureConstants& structure_constants) : G{G}, ordered_basis{G,structure_constants}, w{create_parameters(G.Dimension())} {              
+        inequalities_independent_of_order=inequalities_for_F3_and_F4();
+        constraints_on_prefix.push_back(inequalities_independent_of_brackets());
         advance_until_valid();
     }
 
     const Filtration& operator++() {
-        advance();
+        ++ordered_basis;
         advance_until_valid();
         return *this;
     }
@@ -0,0 +1,170 @@
+#ifndef FOURIERMOTZKIN_H
+#define FOURIERMOTZKIN_H
+
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <boost/dynamic_bitset.hpp>
+
+class CoefficientOverflow : public std::runtime_error {
+public:
+	CoefficientOverflow() : std::runtime_error("coefficient overflow") {}
+};
+
+//the rows of the original system a row is a nonnegative combination of, and the unknowns appearing in them
+struct Ancestry {
+	boost::dynamic_bitset<> rows;
+	boost::dynamic_bitset<> unknowns;
+	Ancestry& operator|=(const Ancestry& other) {
+		rows|=other.rows;
+		unknowns|=other.unknowns;
+		return *this;
+	}
+};
+
+/** A matrix whose rows represent linear expressions a_1x_1+...+a_nx_n+c with rational coefficients.
+
+Rows are stored contiguously; each consists of n+1 integer numerators followed by a positive common denominator, reduced to lowest terms so that equal
+expressions have equal representations. Each row carries its Ancestry, and the number of rows where each unknown appears with a positive or negative
+coefficient is kept up to date. Arithmetic is checked, and CoefficientOverflow is thrown if a coefficient does not fit in 64 bits.
+*/
+class RationalRows {
+	int unknowns;
+	int width;
+	vector<int64_t> data;
+	vector<Ancestry> ancestry_;
+	vector<int> positive_occurrences, negative_occurrences;
+
+	int64_t* row(int i) {return data.data()+i*width;}
+	static int64_t gcd(int64_t a, int64_t b) {
+		if (a==numeric_limits<int64_t>::min() || b==numeric_limits<int64_t>::min()) throw CoefficientOverflow{};
+		return std::gcd(a,b);
+	}
+	//reduce the last row to lowest terms
+	void normalize_last_row() {
+		auto r=row(size()-1);
+		int64_t divisor=r[unknowns+1];
+		for (int k=0;k<=unknowns && divisor!=1;++k) divisor=gcd(divisor,r[k]);
+		if (divisor>1)
+			for (int k=0;k<width;++k) r[k]/=divisor;
+		count(size()-1,1);
+	}
+	void count(int i, int increment) {
+		for (int k=0;k<unknowns;++k)
+			if (coefficient(i,k)>0) positive_occurrences[k]+=increment;
+			else if (coefficient(i,k)<0) negative_occurrences[k]+=increment;
+	}
+	size_t hash(int i) const {
+		size_t result=14695981039346656037ull;
+		for (auto x=begin(i);x!=end(i);++x) {
+			result^=static_cast<size_t>(*x);
+			result*=1099511628211ull;
+		}
+		return result;
+	}
+	bool equal(int i, int j) const {
+		return std::equal(begin(i),end(i),begin(j));
+	}
+public:
+	RationalRows(int unknowns) : unknowns{unknowns}, width{unknowns+2}, positive_occurrences(unknowns), negative_occurrences(unknowns) {}
+	int size() const {return data.size()/width;}
+	bool empty() const {return data.empty();}
+	const int64_t* begin(int i) const {return data.data()+i*width;}
+	const int64_t* end(int i) const {return begin(i)+width;}
+	int64_t coefficient(int i, int k) const {return begin(i)[k];}
+	int64_t constant(int i) const {return begin(i)[unknowns];}
+	int64_t denominator(int i) const {return begin(i)[unknowns+1];}
+	const Ancestry& ancestry(int i) const {return ancestry_[i];}
+	int occurrences(int k) const {return positive_occurrences[k]+negative_occurrences[k];}
+	int positive_occurrences_of(int k) const {return positive_occurrences[k];}
+	int negative_occurrences_of(int k) const {return negative_occurrences[k];}
+	bool is_constant(int i) const {
+		return std::all_of(begin(i),begin(i)+unknowns,[] (int64_t x) {return x==0;});
+	}
+	//the number of unknowns that appear in the ancestors of the i-th row, but not in the row itself
+	int effectively_eliminated(int i) const {
+		int result=0;
+		for (auto k=ancestry_[i].unknowns.find_first();k!=boost::dynamic_bitset<>::npos;k=ancestry_[i].unknowns.find_next(k))
+			if (!coefficient(i,k)) ++result;
+		return result;
+	}
+
+	//append a row with the given numerators (coefficients followed by the constant term) and nonzero denominator
+	void push_back(const int64_t* numerators, int64_t denominator, Ancestry ancestry) {
+		if (denominator==numeric_limits<int64_t>::min()) throw CoefficientOverflow{};
+		int sign=denominator>0? 1 : -1;
+		data.insert(data.end(),numerators,numerators+unknowns+1);
+		data.push_back(denominator);
+		if (sign<0) for (auto x=data.end()-width;x!=data.end();++x) {
+			if (*x==numeric_limits<int64_t>::min()) throw CoefficientOverflow{};
+			*x=-*x;
+		}
+		ancestry_.push_back(move(ancestry));
+		normalize_last_row();
+	}
+	//append the row x_k-e/a_k, where e is the i-th row of other and a_k its coefficient of x_k, assumed nonzero; the result does not depend on x_k
+	void push_back_bound(const RationalRows& other, int i, int k) {
+		vector<int64_t> numerators(other.begin(i),other.begin(i)+unknowns+1);
+		auto a=numerators[k];
+		numerators[k]=0;
+		for (auto& x: numerators) {
+			if (x==numeric_limits<int64_t>::min()) throw CoefficientOverflow{};
+			x=-x;
+		}
+		push_back(numerators.data(),a,other.ancestry(i));
+	}
+	//append the difference of the i-th row of first and the j-th row of second
+	void push_back_difference(const RationalRows& first, int i, const RationalRows& second, int j) {
+		auto x=first.begin(i), y=second.begin(j);
+		auto dx=first.denominator(i), dy=second.denominator(j);
+		vector<int64_t> numerators(unknowns+1);
+		bool overflow=false;
+		for (int k=0;k<=unknowns;++k) {
+			int64_t p, q;
+			overflow|=__builtin_mul_overflow(x[k],dy,&p);
+			overflow|=__builtin_mul_overflow(y[k],dx,&q);
+			overflow|=__builtin_sub_overflow(p,q,&numerators[k]);
+		}
+		int64_t denominator;
+		overflow|=__builtin_mul_overflow(dx,dy,&denominator);
+		if (overflow) throw CoefficientOverflow{};
+		auto ancestry=first.ancestry(i);
+		ancestry|=second.ancestry(j);
+		push_back(numerators.data(),denominator,move(ancestry));
+	}
+	//remove the rows for which predicate returns true
+	template<typename Predicate>
+	void erase_if(Predicate&& predicate) {
+		int kept=0;
+		for (int i=0;i<size();++i)
+			if (predicate(i)) count(i,-1);
+			else {
+				if (kept!=i) {
+					std::copy(begin(i),end(i),row(kept));
+					ancestry_[kept]=move(ancestry_[i]);
+				}
+				++kept;
+			}
+		data.resize(kept*width);
+		ancestry_.resize(kept);
+	}
+	//remove duplicate rows, keeping for each row the ancestry with the least rows
+	void eliminate_duplicates() {
+		std::unordered_multimap<size_t,int> seen;
+		vector<bool> duplicate(size());
+		for (int i=0;i<size();++i) {
+			auto h=hash(i);
+			auto range=seen.equal_range(h);
+			auto same=find_if(range.first,range.second,[this,i] (auto& entry) {return equal(entry.second,i);});
+			if (same==range.second) seen.emplace(h,i);
+			else {
+				duplicate[i]=true;
+				auto& kept=ancestry_[same->second];
+				if (ancestry_[i].rows.count()<kept.rows.count()) kept=ancestry_[i];
+			}
+		}
+		erase_if([&duplicate] (int i) {return duplicate[i];});
+	}
+};
+
+#endif
@@ -1,167 +1,212 @@
 #include <set>
-
-class empty_sequence_t {} empty_sequence;
+#include <memory>
 
 struct comes_before_in_list {
     exvector list;
     bool operator()(ex x, ex y) const {
         return find(list.begin(),list.end(),x)<find(list.begin(),list.end(),y);
-    }  
-};
-
-
-class PartialWeightSequence {
-    using Compare = ex_is_less;
-    exvector w;
-    //comes_before_in_list comparator;
-    Compare comparator;
-    multiset<ex,Compare> unassigned_weights;
-    int multeplicity(ex wi) const {
-        return count(w.begin(),w.end(),wi)+count(unassigned_weights.begin(),unassigned_weights.end(),wi);
-    }
-
-    //return true if w_j is a weight and adding w_k would violate (G1), since w_i+w_j=w_k violates (G1) and i is not less than k
-    bool violates_G1(ex w_i, ex w_j, ex w_k) const {
-        if (w_i==w_j)
-            return multeplicity(w_i)>1;
-        else return multeplicity(w_j);
-    }
-
-    bool adding_preserves_invariance(ex w_k) const {
-        for (auto w_i : unassigned_weights)
-            if (violates_G1(w_i,w_k-w_i,w_k)) return false;
-        return true;
     }
+};
 
-    bool valid() const {return !w.empty();}
-
-    exvector with_added(ex w_k) const {
-        PartialWeightSequence result(*this);
-        result.w.push_back(w_k);
-        result.unassigned_weights.extract(w_k);
-        return result.first_complete();        
-    }
-    ex remove_last() {        
-        auto w_k=w.back();
-        w.pop_back();
-        unassigned_weights.insert(w_k);
-        return w_k;
-    }
+/** The distinct weights of a grading, numbered 0,...,m-1 in the order determined by ex_is_less, together with the tables needed to check (G1)--(G5).
 
+Sums and differences of weights are computed once, so that weight sequences can be represented by sequences of indices and checked with integer operations only.
+The number of distinct weights can be at most 64.
+*/
+class WeightTable {
 public:
-    PartialWeightSequence(const exvector& weights) : 
-        w{weights} {
-    }
-    PartialWeightSequence(const exvector& weights,empty_sequence_t) :// comparator{weights},
-        unassigned_weights{weights.begin(),weights.end(),comparator}    {
-            assert(!weights.empty());
-    }
-    exvector first_complete() const {
-        if (unassigned_weights.empty()) return w;
-        for (auto w_k: unassigned_weights) {
-            //cout<<horizontal(w)<<" "<<w_k<<endl;
-            if (adding_preserves_invariance(w_k)) {
-                auto with_k=with_added(w_k);                
-              //  cout<<horizontal(with_k)<<endl;
-                if (!with_k.empty()) return with_k;                
-            }
-        }
-        return {};
-    }
-    exvector next_complete(ex lbound_for_wk) const {
-        for (auto w_k: unassigned_weights) {
-            //cout<<"completing: "<<horizontal(w)<<" "<<w_k<<endl;
-            if (comparator(lbound_for_wk,w_k) && adding_preserves_invariance(w_k)) {            
-                auto with_k=with_added(w_k);   
-              //  cout<<horizontal(with_k)<<endl;             
-                if (!with_k.empty()) return with_k;
-                else lbound_for_wk=w_k; //avoid trying duplicates (taking advantage of the fact that the multiset is ordered by comparator)
-            }
+    using Mask = uint64_t;
+private:
+    exvector weights;
+    vector<int> multiplicity_;
+    vector<int> sum_;              //sum_[a*m+b] is the index of weights[a]+weights[b], or -1 if it is not a weight
+    vector<Mask> forbidden_before_;
+public:
+    static Mask bit(int i) {return Mask{1}<<i;}
+    WeightTable(const exvector& all_weights) {
+        map<ex,int,ex_is_less> index;
+        for (auto& x: all_weights) ++index[x];
+        if (index.size()>64) throw invalid_argument("WeightTable: more than 64 distinct weights");
+        for (auto& weight_and_multiplicity : index) {
+            weights.push_back(weight_and_multiplicity.first);
+            multiplicity_.push_back(weight_and_multiplicity.second);
+            weight_and_multiplicity.second=weights.size()-1;
         }
-        return {};
-    }
-    exvector next() {
-        exvector next;
-        while (!w.empty() && next.empty()) {
-            auto last=remove_last();
-            //cout<<"removed "<<horizontal(w)<<" "<<last<<endl;
-            next=next_complete(last);                        
+        int m=weights.size();
+        auto index_of=[&index] (ex x) {
+            auto i=index.find(x);
+            return i==index.end()? -1 : i->second;
+        };
+        sum_.resize(m*m);
+        forbidden_before_.resize(m);
+        for (int a=0;a<m;++a)
+        for (int b=0;b<m;++b) {
+            sum_[a*m+b]=index_of(weights[a]+weights[b]);
+            //w_a+w_j=w_b for some weight w_j
+            int j=index_of(weights[b]-weights[a]);
+            if (j==a? multiplicity_[a]>1 : j>=0) forbidden_before_[b]|=bit(a);
         }
-        return next;
     }
+    int size() const {return weights.size();}
+    ex weight(int a) const {return weights[a];}
+    int multiplicity(int a) const {return multiplicity_[a];}
+    int sum(int a, int b) const {return sum_[a*size()+b];}
+    //the set of a such that w_a+w_j=w_b for some weight w_j, not counting w_j=w_a if w_a has multiplicity one; by (G1), w_b cannot precede any such w_a
+    Mask forbidden_before(int b) const {return forbidden_before_[b];}
 };
 
-class Iterator {
-    void advance_until_valid() {
-        do {
-            PartialWeightSequence p{w};
-            w=p.next();
+/** A weight sequence, represented as a sequence of indices in a WeightTable, which is completed in lexicographic order by backtracking in place.
+
+The weights not yet in the sequence are represented by the number of occurrences left for each index, and by the set of indices for which it is positive.
+All storage is allocated on construction, so that moving to the next sequence does not allocate memory. Only sequences satisfying (G1)--(G5) are generated:
+(G1) is enforced when choosing the next weight, and each condition of (G2)--(G5) is checked as soon as the positions it involves have been filled, so
+that prefixes violating it are not extended.
+*/
+class PartialWeightSequence {
+    using Mask = WeightTable::Mask;
+    const WeightTable* table;
+    vector<int> w;
+    vector<int> unassigned_weights;   //unassigned_weights[a] is the number of occurrences of w_a not in w
+    Mask unassigned=0;
+    int n=0;                          //the length of a complete sequence
+
+    //the set of indices greater than i
+    static Mask above(int i) {return i>=63? 0 : ~Mask{0}<<(i+1);}
+    bool adding_preserves_invariance(int w_k) const {
+        return !(unassigned & table->forbidden_before(w_k));
+    }
+    //the smallest index greater than after which can be appended to w without violating (G1)
+    optional<int> first_available_after(int after) const {
+        for (Mask candidates=unassigned & above(after);candidates;candidates&=candidates-1) {
+            int w_k=__builtin_ctzll(candidates);
+            if (adding_preserves_invariance(w_k)) return w_k;
         }
-        while (!w.empty() && !is_valid());
-    }
-    bool wi_plus_wihat_equals_wj_violates(int i, int ihat, int j) const { //if w[i]+w[ihat]=w[j]
-        if (j<w.size()-1) return true; //violates (G2)
+        return nullopt;
+    }
+    int hat(int i) const {return n-i-1;}
+    int multiplicity(int weight) const {return table->multiplicity(weight);}
+    //true if w_i+w_ihat is a weight and (G2) requires it to occur more than once, or (G3) or (G4) fail
+    bool wi_plus_wihat_violates(int i) const {
+        int ihat=hat(i);
+        int wi_plus_wihat=table->sum(w[i],w[ihat]);
+        if (wi_plus_wihat<0) return false;
+        if (multiplicity(wi_plus_wihat)>1) return true; //violates (G2)
         if (w[i]!=w[ihat] && multiplicity(w[i])==1 && multiplicity(w[ihat])==1) return true; //violates (G3)
         if (w[i]==w[ihat] && i!=ihat && multiplicity(w[i])<=2) return true; //violates (G4)
         return false;
     }
-
-    bool is_valid() const {
-        for (int i=0;i<(w.size()+1)/2;++i) {
-            auto ihat=w.size()-i-1;
-            auto wi_plus_wihat=w[i]+w[ihat];
-            auto j=find(w.begin(),w.end(),wi_plus_wihat)-w.begin();
-            if (j<w.size() && wi_plus_wihat_equals_wj_violates(i,ihat,j)) return false;            
+    bool violates_G5(int i, int j) const {
+        return table->sum(w[i],w[j])>=0 && table->sum(w[hat(i)],w[hat(j)])>=0 && (j!=hat(i) || i!=hat(j));
+    }
+    //true if the conditions (G2)--(G5) that involve the last position filled and no position after it fail
+    bool last_violates() const {
+        int p=w.size()-1;
+        if (hat(p)<=p) {
+            if (wi_plus_wihat_violates(hat(p))) return true;
+            int wi_plus_wihat=table->sum(w[hat(p)],w[p]);
+            if (wi_plus_wihat>=0 && (p==n-1? w[p]!=wi_plus_wihat : !unassigned_weights[wi_plus_wihat])) return true; //violates (G2)
         }
-        for (int i=0;i<w.size();++i) {
-            auto ihat=w.size()-i-1;
-            for (int j=0;j<(w.size()+1)/2;++j) {
-                auto jhat=w.size()-j-1;
-                if (multiplicity(w[i]+w[j]) && multiplicity(w[ihat]+w[jhat]) && (j!=ihat || i!=jhat)) return false; //violates (G5)
+        if (p<n-1)
+            for (int q=0;q<p;++q)
+                if (hat(q)<=q && table->sum(w[hat(q)],w[q])==w[p]) return true; //violates (G2), since w[p] must be the last weight
+        auto filled=[this,p] (int i) {return i<=p && hat(i)<=p;};
+        for (int i : {p,hat(p)})
+            for (int j=0;j<(n+1)/2;++j)
+                if (filled(i) && filled(j) && violates_G5(i,j)) return true;
+        for (int j : {p,hat(p)})
+            for (int i=0;i<n && j<(n+1)/2;++i)
+                if (filled(i) && filled(j) && violates_G5(i,j)) return true;
+        return false;
+    }
+    void push(int w_k) {
+        w.push_back(w_k);
+        if (!--unassigned_weights[w_k]) unassigned&=~WeightTable::bit(w_k);
+    }
+    int pop() {
+        auto w_k=w.back();
+        w.pop_back();
+        ++unassigned_weights[w_k];
+        unassigned|=WeightTable::bit(w_k);
+        return w_k;
+    }
+    //starting from the current prefix, look for the first complete sequence whose element after the prefix is greater than after; if there is none, w is left empty
+    void complete(int after=-1) {
+        while (true) {
+            if (auto next=first_available_after(after)) {
+                push(next.value());
+                if (last_violates()) after=pop();
+                else if (w.size()==n) return;
+                else after=-1;
             }
+            else if (w.empty()) return;
+            else after=pop();
         }
-        return true;
     }
-    exvector w;
-    int multiplicity(ex weight) const {
-        return count(w.begin(),w.end(),weight);
+public:
+    PartialWeightSequence()=default;
+    PartialWeightSequence(const WeightTable& table) :
+        table{&table}, unassigned_weights(table.size()) {
+            assert(table.size());
+            for (int a=0;a<table.size();++a) {
+                unassigned_weights[a]=table.multiplicity(a);
+                unassigned|=WeightTable::bit(a);
+                n+=table.multiplicity(a);
+            }
+            w.reserve(n);
+            complete();
+    }
+    //take the next complete sequence in lexicographic order
+    PartialWeightSequence& operator++() {
+        if (!w.empty()) complete(pop());
+        return *this;
     }
+    const vector<int>& operator*() const {return w;}
+};
+
+class Iterator {
+    shared_ptr<const WeightTable> table;
+    PartialWeightSequence sequence;
 public:
-    static Iterator begin(const exvector& weights) {
+    static Iterator begin(shared_ptr<const WeightTable> table) {
         Iterator result;
-        PartialWeightSequence p{weights,empty_sequence};
-        result.w=p.first_complete();
-        if (result.w.size() && !result.is_valid()) result.advance_until_valid();
+        result.table=move(table);
+        result.sequence=PartialWeightSequence{*result.table};
         return result;
     }
-    static Iterator end(const exvector& weights) {
+    static Iterator end(shared_ptr<const WeightTable> table) {
         return Iterator{};
     }
     Iterator& operator++() {
-        advance_until_valid();
+        ++sequence;
         return *this;
-    }    
+    }
     bool operator!=(const Iterator& o) const {
-        return w!=o.w;
+        return *sequence!=*o.sequence;
     }
     Iterator operator++(int) {
         Iterator result(*this);
         ++*this;
         return result;
     }
-    exvector operator*() const {return w;}
+    exvector operator*() const {
+        exvector result;
+        transform((*sequence).begin(),(*sequence).end(),back_inserter(result),[this] (int a) {return table->weight(a);});
+        return result;
+    }
 };
 
 class WeightSequencesRespectingOrder {
     exvector weights;
+    shared_ptr<const WeightTable> table;
 public:
-    WeightSequencesRespectingOrder(const exvector& weights) : weights{weights} {     
+    WeightSequencesRespectingOrder(const exvector& weights) : weights{weights} {
+        if (!weights.empty()) table=make_shared<WeightTable>(weights);
     }
     Iterator begin() const {
-        return (weights.empty())? Iterator::end(weights) : Iterator::begin(weights);
+        return (weights.empty())? Iterator::end(table) : Iterator::begin(table);
     }
     Iterator end() const {
-        return Iterator::end(weights);
+        return Iterator::end(table);
     }
     vector<int> as_indices(const exvector& weights) const {
         auto original_weights=this->weights;
@@ -0,0 +1,194 @@
+#ifndef IDEALCACHE_H
+#define IDEALCACHE_H
+
+#include "cache.h"
+
+//a polynomial with rational coefficients in variables x_0,...,x_{m-1}, represented by pairs of exponents and coefficients sorted by exponents
+using Terms = map<vector<int>,numeric>;
+
+//the terms of a polynomial in the given variables, or nullopt if its coefficients are not rational numbers
+optional<Terms> terms(ex polynomial, const exvector& variables) {
+	Terms result;
+	polynomial=polynomial.expand();
+	if (polynomial.is_zero()) return result;
+	exvector monomials;
+	if (is_a<add>(polynomial)) monomials.assign(polynomial.begin(),polynomial.end());
+	else monomials.push_back(polynomial);
+	for (auto& monomial: monomials) {
+		vector<int> exponents;
+		ex coefficient=monomial;
+		for (auto& x: variables) {
+			exponents.push_back(monomial.degree(x));
+			coefficient=coefficient.coeff(x,exponents.back());
+		}
+		if (!is_a<numeric>(coefficient) || !ex_to<numeric>(coefficient).is_rational()) return nullopt;
+		result[exponents]+=ex_to<numeric>(coefficient);
+	}
+	return result;
+}
+
+//inverse of terms
+ex polynomial(const Terms& terms, const exvector& variables) {
+	ex result;
+	for (auto& term: terms) {
+		ex monomial=term.second;
+		for (int i=0;i<variables.size();++i) monomial*=pow(variables[i],term.first[i]);
+		result+=monomial;
+	}
+	return result;
+}
+
+//represent a polynomial as a string of the form "c:e_0,...,e_{m-1} c:e_0,...,e_{m-1}...", where each c is a fraction
+string terms_to_string(const Terms& terms) {
+	stringstream s;
+	for (auto& term: terms) {
+		s<<term.second.numer()<<"/"<<term.second.denom()<<":";
+		for (int i=0;i<term.first.size();++i) s<<(i? ",":"")<<term.first[i];
+		s<<" ";
+	}
+	return s.str();
+}
+
+//inverse of terms_to_string
+Terms terms_from_string(const string& polynomial) {
+	Terms result;
+	stringstream s{polynomial};
+	string term;
+	while (s>>term) {
+		auto slash=term.find('/'), colon=term.find(':');
+		if (slash==string::npos || colon==string::npos || colon<slash) throw std::invalid_argument("invalid cache entry: "+polynomial);
+		vector<int> exponents;
+		stringstream e{term.substr(colon+1)};
+		for (string exponent;getline(e,exponent,',');) exponents.push_back(stoi(exponent));
+		result[exponents]=numeric(term.substr(0,slash).c_str())/numeric(term.substr(slash+1,colon-slash-1).c_str());
+	}
+	return result;
+}
+
+//the polynomial obtained by renaming each variable x_{order[k]} to x_k
+Terms renamed(const Terms& terms, const vector<int>& order) {
+	Terms result;
+	for (auto& term: terms) {
+		vector<int> exponents;
+		for (int i: order) exponents.push_back(term.first[i]);
+		result.emplace(move(exponents),term.second);
+	}
+	return result;
+}
+
+/** An ordering of the variables that only depends on the way each variable appears in the polynomials, so that ideals which differ by a renaming of the
+variables are usually put in the same form by renaming the variables in this order. Variables that cannot be told apart are left in their original order.
+@param polynomials The generators of an ideal
+@param f A distinguished polynomial
+@return A vector containing the index of each variable, in the new order
+*/
+vector<int> normal_order(const vector<Terms>& polynomials, const Terms& f, int variables) {
+	using Occurrences = vector<pair<int,int>>;	//the exponent of a variable and the degree of each term containing it
+	auto occurrences=[] (const Terms& polynomial, int i) {
+		Occurrences result;
+		for (auto& term: polynomial)
+			if (term.first[i]) result.emplace_back(term.first[i],accumulate(term.first.begin(),term.first.end(),0));
+		sort(result.begin(),result.end());
+		return result;
+	};
+	vector<pair<vector<Occurrences>,Occurrences>> invariants;
+	for (int i=0;i<variables;++i) {
+		vector<Occurrences> in_generators;
+		for (auto& polynomial: polynomials) in_generators.push_back(occurrences(polynomial,i));
+		sort(in_generators.begin(),in_generators.end());
+		invariants.emplace_back(move(in_generators),occurrences(f,i));
+	}
+	vector<int> order(variables);
+	iota(order.begin(),order.end(),0);
+	stable_sort(order.begin(),order.end(),[&invariants] (int i, int j) {return invariants[i]<invariants[j];});
+	return order;
+}
+
+/** Memoizes the computations with polynomial ideals performed by CoCoA.
+
+Whether the radical of an ideal contains a polynomial does not depend on the order of the generators, nor on the names of the variables; hence, it is cached
+under a key obtained by sorting the generators after renaming the variables in normal order, so that ideals which only differ by a renaming of the variables
+usually share an entry. The generators returned by IdealReduce depend on the order of the variables, so reductions are cached under a key listing the
+generators as given, so that the output does not depend on the contents of the cache. If a directory is given, entries are also stored on disk, so that they
+are reused by later runs and shared by processes running concurrently. Ideals whose generators do not have rational coefficients are not cached.
+*/
+class IdealCache {
+	map<string,bool> radical_membership;
+	map<string,exvector> reductions;
+	optional<ResultCache> disk;
+
+	static optional<vector<Terms>> generators(const exvector& variables, const exvector& ideal) {
+		vector<Terms> result;
+		for (auto& x: ideal)
+			if (auto polynomial=terms(x,variables)) result.push_back(move(polynomial.value()));
+			else return nullopt;
+		return result;
+	}
+	static optional<string> radical_membership_key(const exvector& variables, const exvector& ideal, ex f) {
+		auto polynomials=generators(variables,ideal);
+		auto f_terms=terms(f,variables);
+		if (!polynomials || !f_terms) return nullopt;
+		auto order=normal_order(polynomials.value(),f_terms.value(),variables.size());
+		set<string> renamed_generators;
+		for (auto& polynomial: polynomials.value()) renamed_generators.insert(terms_to_string(renamed(polynomial,order)));
+		string key=to_string(variables.size())+"|"+terms_to_string(renamed(f_terms.value(),order));
+		for (auto& generator: renamed_generators) key+="|"+generator;
+		return key;
+	}
+	static optional<string> reduction_key(const exvector& variables, const exvector& ideal) {
+		auto polynomials=generators(variables,ideal);
+		if (!polynomials) return nullopt;
+		string key=to_string(variables.size());
+		for (auto& polynomial: polynomials.value()) key+="|"+terms_to_string(polynomial);
+		return key;
+	}
+public:
+	//store entries in a ResultCache in the given directory
+	void use_directory(const string& dir) {disk.emplace(dir);}
+
+	//equivalent to CocoaPolyAlgorithms_R::RadicalContains
+	bool radical_contains(const exvector& variables, const exvector& ideal, ex f) {
+		auto compute=[&variables,&ideal,f] () {return CocoaPolyAlgorithms_R::RadicalContains<symbol>(variables,ideal.begin(),ideal.end(),f);};
+		auto key=radical_membership_key(variables,ideal,f);
+		if (!key) return compute();
+		auto i=radical_membership.find(key.value());
+		if (i!=radical_membership.end()) return i->second;
+		optional<bool> result;
+		if (disk)
+			if (auto cached=disk->get("radical-membership",key.value())) result=*cached=="1";
+		if (!result) {
+			result=compute();
+			if (disk) disk->put("radical-membership",key.value(),result.value()? "1" : "0");
+		}
+		return radical_membership[key.value()]=result.value();
+	}
+
+	//equivalent to CocoaPolyAlgorithms_R::IdealReduce
+	exvector ideal_reduce(const exvector& variables, const exvector& ideal) {
+		auto compute=[&variables,&ideal] () {return CocoaPolyAlgorithms_R::IdealReduce<symbol>(variables,ideal.begin(),ideal.end());};
+		auto key=reduction_key(variables,ideal);
+		if (!key) return compute();
+		auto i=reductions.find(key.value());
+		if (i!=reductions.end()) return i->second;
+		if (disk)
+			if (auto cached=disk->get("ideal-reduction",key.value())) {
+				exvector result;
+				stringstream s{*cached};
+				for (string line;getline(s,line);) result.push_back(polynomial(terms_from_string(line),variables));
+				return reductions[key.value()]=result;
+			}
+		auto result=compute();
+		if (disk)
+			if (auto reduced=generators(variables,result)) {
+				string value;
+				for (auto& polynomial: reduced.value()) value+=terms_to_string(polynomial)+"\n";
+				disk->put("ideal-reduction",key.value(),value);
+			}
+		return reductions[key.value()]=result;
+	}
+};
+
+//the cache used for all computations with ideals
+IdealCache ideal_cache;
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
+#include <map>
+#include "fdio.h"
+
+/** An append-only file recording the output of each row of a table as soon as it has been computed, so that an interrupted computation can be resumed.
+
+Each record consists of a line "row <index> <status> <size>" followed by size bytes of output, and it is flushed to disk with fsync before the
+next row is recorded. A truncated record at the end of the file, left by a process killed while writing it, is discarded when the journal is reopened.
+*/
+class Journal {
+public:
+	struct Entry {
+		string status;
+		string output;
+	};
+private:
+	string filename;
+	int fd=-1;
+	map<int,Entry> entries;
+
+	//read the complete records in the file, returning the size of the part of the file they occupy
+	off_t load(const string& table, int rows) {
+		std::ifstream is{filename,std::ios::binary};
+		if (!is) throw std::runtime_error("cannot read journal "+filename);
+		string header;
+		if (!getline(is,header) || header!=header_for(table,rows))
+			throw std::invalid_argument("journal "+filename+" does not refer to a table \""+table+"\" with "+to_string(rows)+" rows");
+		off_t valid_size=is.tellg();
+		string line;
+		while (getline(is,line)) {
+			stringstream s{line};
+			string keyword;
+			int row;
+			Entry entry;
+			uint64_t size;
+			if (!(s>>keyword>>row>>entry.status>>size) || keyword!="row") break;
+			entry.output.resize(size);
+			if (!is.read(&entry.output[0],size)) break;
+			entries[row]=move(entry);
+			valid_size=is.tellg();
+		}
+		return valid_size;
+	}
+	static string header_for(const string& table, int rows) {
+		return "skoll journal, table: "+table+", rows: "+to_string(rows);
+	}
+	void sync() {
+		if (fsync(fd)) throw std::runtime_error("cannot sync journal "+filename+": "+strerror(errno));
+	}
+public:
+/** Open a journal
+
+ @param filename The name of the file containing the journal
+ @param table A string identifying the table and the settings its rows depend on; a journal can only be resumed with the same string
+ @param rows The number of rows of the table
+ @param resume If true, rows recorded in an existing journal are considered computed, and new rows are appended; otherwise, a new journal is created
+*/
+	Journal(const string& filename, const string& table, int rows, bool resume) : filename{filename} {
+		if (resume) {
+			auto valid_size=load(table,rows);
+			fd=open(filename.c_str(),O_WRONLY|O_APPEND);
+			if (fd<0 || ftruncate(fd,valid_size)) throw std::runtime_error("cannot open journal "+filename+": "+strerror(errno));
+		}
+		else {
+			fd=open(filename.c_str(),O_WRONLY|O_APPEND|O_CREAT|O_EXCL,0644);
+			if (fd<0) throw std::runtime_error("cannot create journal "+filename+": "+strerror(errno)+" (use --resume to continue an existing journal)");
+			auto header=header_for(table,rows)+"\n";
+			fdio::write_fully(fd,header.data(),header.size());
+			sync();
+		}
+	}
+	Journal(const Journal&)=delete;
+	Journal& operator=(const Journal&)=delete;
+	~Journal() {
+		close(fd);
+	}
+	const map<int,Entry>& recorded() const {return entries;}
+	void record(int row, const string& status, const string& output) {
+		auto record="row "+to_string(row)+" "+status+" "+to_string(output.size())+"\n"+output;
+		fdio::write_fully(fd,record.data(),record.size());
+		sync();
+		entries[row]=Entry{status,output};
+	}
+};
+
+#endif
@@ -2,68 +2,84 @@
 //iterates through linear extensions of a poset in lexicographic order wrt some other total ordering <
 //the partial ordering is passed in the constructor as a subset of the Cartesian product
 //the total ordering to use for lexicographic ordering is T::operator<(T)
+//optionally, a function can be passed to exclude prefixes: linear extensions starting with a prefix for which it returns false are skipped without being generated
+//the poset is represented by bitmasks, so it can have at most 64 elements
 template<typename T>
 struct LinearExtension {
-    set<T> to_add; //use of set ensures that iteration through to_add is done relative to the total ordering. public functions leave this empty
-    set<pair<T,T>> partial_order_relation;  
+    using Mask = uint64_t;
+    vector<T> elements;         //sorted relative to the total ordering
+    vector<Mask> predecessors;  //predecessors[i] is the set of indices of the elements that must precede elements[i]
+    Mask placed=0;              //the set of indices of elements in order
+    vector<int> indices;        //the indices of the elements in order
     vector<T> order;
+    function<bool(const vector<T>&)> admissible_prefix;
 
-    bool less_than_in_partial_order(T first, T second) const {
-        return partial_order_relation.count(make_pair(first,second));
+    static Mask bit(int i) {return Mask{1}<<i;}
+    static vector<T> sorted(const vector<T>& poset) {
+        set<T> elements(poset.begin(),poset.end());
+        return {elements.begin(),elements.end()};
     }
-
-    bool has_incoming_edges_from_to_add(T node) const {
-        for (auto n: to_add)
-            if (less_than_in_partial_order(n,node)) return true;
-        return false;
+    //the smallest index greater than after of an element not in order whose predecessors are all in order
+    optional<int> first_available_after(int after) const {
+        for (int i=after+1;i<elements.size();++i)
+            if (!(placed & bit(i)) && !(predecessors[i] & ~placed)) return i;
+        return nullopt;
     }
-    T first_element_with_no_incoming_edges_from_to_add() const {
-        for (auto n: to_add)
-            if (!has_incoming_edges_from_to_add(n)) return n;
-        throw logic_error("error in LinearExtension: not_a_poset");
+    void push(int i) {
+        placed|=bit(i);
+        indices.push_back(i);
+        order.push_back(elements[i]);
     }
-    void complete() {
-        while (!to_add.empty()) {
-            auto node=first_element_with_no_incoming_edges_from_to_add();
-            to_add.erase(node);
-            order.push_back(node);
+    int pop() {
+        int i=indices.back();
+        placed&=~bit(i);
+        indices.pop_back();
+        order.pop_back();
+        return i;
+    }
+    //starting from the current prefix, look for the first admissible linear extension whose element after the prefix has index greater than after; if there is none, order is left empty
+    void complete(int after=-1) {
+        while (true) {
+            auto next=first_available_after(after);
+            if (next) {
+                push(next.value());
+                if (admissible_prefix && !admissible_prefix(order)) after=pop();
+                else if (indices.size()==elements.size()) return;
+                else after=-1;
+            }
+            else if (after<0 && indices.size()<elements.size()) throw logic_error("error in LinearExtension: not_a_poset");
+            else if (indices.empty()) return;
+            else after=pop();
         }
     }
-    optional<T> first_element_with_no_incoming_edges_from_to_add_and_greater_than(T node) const {
-        for (auto n: to_add)
-            if (n>node && !has_incoming_edges_from_to_add(n)) return n;
-        return nullopt;
-    }    
-    LinearExtension(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation) : to_add(poset.begin(),poset.end()), partial_order_relation{partial_order_relation} {
+    LinearExtension(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation, function<bool(const vector<T>&)> admissible_prefix)
+        : elements{sorted(poset)}, predecessors(elements.size()), admissible_prefix{move(admissible_prefix)} {
+        if (elements.size()>64) throw logic_error("error in LinearExtension: too many elements");
+        auto index=[this] (T x) {return lower_bound(elements.begin(),elements.end(),x)-elements.begin();};
+        for (auto& relation : partial_order_relation)
+            predecessors[index(relation.second)]|=bit(index(relation.first));
         complete();
     }
     LinearExtension()=default;
 public:
-    static LinearExtension begin(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation) {
-        return LinearExtension{poset,partial_order_relation};
+    static LinearExtension begin(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation, function<bool(const vector<T>&)> admissible_prefix={}) {
+        return LinearExtension{poset,partial_order_relation,move(admissible_prefix)};
     }
     static LinearExtension end(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation) {
         return LinearExtension{};
     }
 
 
-//take the next linear extension in lexicographic order. 
+//take the next linear extension in lexicographic order.
     LinearExtension& operator++() {
-        //starting from the end, remove elements from order, and try to replace them with higher values
-        optional<T> next;
-        while (!next && !order.empty()) {
-            auto last=order.back();
-            order.pop_back();
-            to_add.insert(last);
-            next=first_element_with_no_incoming_edges_from_to_add_and_greater_than(last);
-        }
-        if (next) {
-            to_add.erase(next.value());
-            order.push_back(next.value());
-            complete();        
-        }        
+        if (!indices.empty()) complete(pop());
         return *this;
     }
+//skip the remaining linear extensions that start with the first length elements of the current one
+    LinearExtension& advance_past_prefix(int length) {
+        while (indices.size()>length) pop();
+        return ++*this;
+    }
     bool operator!=(const LinearExtension& other) const  {
         return order!=other.order;
     }
@@ -78,8 +94,8 @@ template<typename T>
 class LinearExtensions {
     LinearExtension<T> begin_,end_;
 public:
-    LinearExtensions(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation) 
+    LinearExtensions(const vector<T>& poset, const set<pair<T,T>>& partial_order_relation)
         : begin_{LinearExtension<T>::begin(poset,partial_order_relation)}, end_{LinearExtension<T>::end(poset,partial_order_relation)} {}
     auto begin() const {return begin_;}
     auto end() const {return end_;}
-};
\ No newline at end of file
+};
@@ -1,8 +1,18 @@
 #ifndef LINEARINEQUALITIES_H
 #define LINEARINEQUALITIES_H
  
+#include "simplex.h"
+#include "fouriermotzkin.h"
+
 using namespace GiNaC;
 
+//the algorithm used to determine whether a system of linear inequalities has a solution
+enum class FeasibilityAlgorithm {
+	SIMPLEX, FOURIER_MOTZKIN
+};
+
+FeasibilityAlgorithm feasibility_algorithm=FeasibilityAlgorithm::SIMPLEX;
+
 template<typename iter_begin,typename iter_end, typename Closure>
 iter_begin minimize_value(iter_begin begin, iter_end end, Closure&& closure) {
 	int minimum=numeric_limits<int>::max();
@@ -217,6 +227,176 @@ ostream& operator<<(ostream& os, const IntermediateInequalities& o) {
 	return os<<"IntermediateInequalities object with sizes : "<<o.dbg_print();
 }
 
+//if positive, redundant inequalities are removed by linear programming whenever Fourier-Motzkin elimination produces more than this number of inequalities
+int lp_redundancy_threshold=0;
+
+/** Fourier-Motzkin elimination on inequalities with rational coefficients, stored as rows of integers.
+
+Each row keeps track of the rows of the original system it is a combination of. By Imbert's acceleration theorem, which refines Chernikov's rule, a row
+with more than 1+k ancestors, where k is the number of unknowns appearing in its ancestors but not in the row itself, is a combination of other rows, and
+is discarded. The unknown to eliminate is the one minimizing the growth in the number of rows; if lp_redundancy_threshold is set, rows implied by the
+others are also removed by linear programming when the system grows too large.
+
+Throws CoefficientOverflow if the coefficients become too large, in which case the symbolic representation should be used.
+*/
+class RationalFourierMotzkin {
+	exvector unknowns;
+	RationalRows positive, nonnegative;	//the inequalities x>0 and x>=0
+	vector<bool> eliminated;
+	int original_rows;
+	int next_lp_redundancy_check=lp_redundancy_threshold;
+
+	static int64_t to_int64(const numeric& x) {
+		if (!x.is_integer() || abs(x)>numeric(numeric_limits<long>::max())) throw CoefficientOverflow{};
+		return x.to_long();
+	}
+	void insert(const RationalInequality& inequality, int index) {
+		numeric denominator=inequality.constant.denom();
+		for (auto& x: inequality.coefficients) denominator=lcm(denominator,x.denom());
+		vector<int64_t> numerators;
+		for (auto& x: inequality.coefficients) numerators.push_back(to_int64(x*denominator));
+		numerators.push_back(to_int64(inequality.constant*denominator));
+		Ancestry ancestry{boost::dynamic_bitset<>(original_rows),boost::dynamic_bitset<>(unknowns.size())};
+		ancestry.rows.set(index);
+		for (int k=0;k<unknowns.size();++k)
+			if (numerators[k]) ancestry.unknowns.set(k);
+		(inequality.strict? positive : nonnegative).push_back(numerators.data(),to_int64(denominator),move(ancestry));
+	}
+	ex to_ex(const RationalRows& rows, int i) const {
+		ex result=numeric(rows.constant(i));
+		for (int k=0;k<unknowns.size();++k)
+			if (rows.coefficient(i,k)) result+=numeric(rows.coefficient(i,k))*unknowns[k];
+		return result/numeric(rows.denominator(i));
+	}
+	list<ex> to_ex(const RationalRows& rows) const {
+		list<ex> result;
+		for (int i=0;i<rows.size();++i) result.push_back(to_ex(rows,i));
+		return result;
+	}
+	RationalInequality to_rational_inequality(const RationalRows& rows, int i, bool strict) const {
+		RationalInequality result;
+		numeric denominator{rows.denominator(i)};
+		for (int k=0;k<unknowns.size();++k) result.coefficients.push_back(numeric(rows.coefficient(i,k))/denominator);
+		result.constant=numeric(rows.constant(i))/denominator;
+		result.strict=strict;
+		return result;
+	}
+	static bool remove_constant_inequalities(RationalRows& rows, bool strict) {
+		bool violated=false;
+		rows.erase_if([&rows,&violated,strict] (int i) {
+			if (!rows.is_constant(i)) return false;
+			auto c=rows.constant(i);
+			if (strict? c<=0 : c<0) violated=true;
+			return true;
+		});
+		return !violated;
+	}
+	bool remove_constant_inequalities() {
+		return remove_constant_inequalities(positive,true) && remove_constant_inequalities(nonnegative,false);
+	}
+	//the unknown whose elimination adds the least rows, i.e. minimizes pq-p-q, where p and q are the numbers of upper and lower bounds
+	int variable_to_eliminate() const {
+		vector<int> indices(unknowns.size());
+		iota(indices.begin(),indices.end(),0);
+		return *minimize_value(indices.begin(),indices.end(),[this] (int k) {
+			long lower=positive.positive_occurrences_of(k)+nonnegative.positive_occurrences_of(k);
+			long upper=positive.negative_occurrences_of(k)+nonnegative.negative_occurrences_of(k);
+			if (!lower && !upper) return numeric_limits<int>::max();
+			return static_cast<int>(min<long>(lower*upper-lower-upper,numeric_limits<int>::max()-1));
+		});
+	}
+	//move the bounds on x_k given by rows to upper and lower, removing the rows that depend on x_k
+	void extract_bounds(RationalRows& rows, int k, RationalRows& upper, RationalRows& lower) {
+		rows.erase_if([&rows,&upper,&lower,k] (int i) {
+			auto a=rows.coefficient(i,k);
+			if (a>0) lower.push_back_bound(rows,i,k);
+			else if (a<0) upper.push_back_bound(rows,i,k);
+			return a!=0;
+		});
+	}
+	static void insert_differences(RationalRows bigger, RationalRows smaller, RationalRows& destination) {
+		bigger.eliminate_duplicates();
+		smaller.eliminate_duplicates();
+		for (int i=0;i<bigger.size();++i)
+		for (int j=0;j<smaller.size();++j)
+			destination.push_back_difference(bigger,i,smaller,j);
+	}
+	static void remove_rows_with_too_many_ancestors(RationalRows& rows, int first_new_row) {
+		rows.erase_if([&rows,first_new_row] (int i) {
+			return i>=first_new_row && rows.ancestry(i).rows.count()>1+rows.effectively_eliminated(i);
+		});
+	}
+	//remove each row implied by the other rows, i.e. such that the system obtained by replacing it with its negation has no solution
+	void remove_rows_implied_by_others() {
+		vector<bool> redundant_positive(positive.size()), redundant_nonnegative(nonnegative.size());
+		auto system_without=[&] (const RationalRows* rows, int excluded) {
+			vector<RationalInequality> result;
+			for (int i=0;i<positive.size();++i)
+				if (!redundant_positive[i] && !(rows==&positive && i==excluded)) result.push_back(to_rational_inequality(positive,i,true));
+			for (int i=0;i<nonnegative.size();++i)
+				if (!redundant_nonnegative[i] && !(rows==&nonnegative && i==excluded)) result.push_back(to_rational_inequality(nonnegative,i,false));
+			return result;
+		};
+		auto is_implied=[&] (const RationalRows& rows, int i, bool strict) {
+			auto system=system_without(&rows,i);
+			auto negation=to_rational_inequality(rows,i,!strict);
+			for (auto& x: negation.coefficients) x=-x;
+			negation.constant=-negation.constant;
+			system.push_back(negation);
+			return !simplex::feasible_point(system,unknowns.size());
+		};
+		for (int i=0;i<positive.size();++i) redundant_positive[i]=is_implied(positive,i,true);
+		for (int i=0;i<nonnegative.size();++i) redundant_nonnegative[i]=is_implied(nonnegative,i,false);
+		positive.erase_if([&redundant_positive] (int i) {return redundant_positive[i];});
+		nonnegative.erase_if([&redundant_nonnegative] (int i) {return redundant_nonnegative[i];});
+	}
+	void eliminate(int k, IntermediateInequalities& intermediate_inequalities) {
+		for (auto rows : {&positive,&nonnegative})
+			if (rows->size()>10000) throw OutOfMemory("too many inequalities: "+to_string(rows->size()));
+		int n=unknowns.size();
+		RationalRows strictly_upper{n}, strictly_lower{n}, upper{n}, lower{n};
+		extract_bounds(positive,k,strictly_upper,strictly_lower);
+		extract_bounds(nonnegative,k,upper,lower);
+		eliminated[k]=true;
+		intermediate_inequalities.update(unknowns[k],
+			ComparableToVariable{to_ex(strictly_upper),to_ex(strictly_lower)},
+			ComparableToVariable{to_ex(upper),to_ex(lower)}
+		);
+		int first_new_positive=positive.size(), first_new_nonnegative=nonnegative.size();
+		insert_differences(strictly_upper,strictly_lower,positive);
+		insert_differences(strictly_upper,lower,positive);
+		insert_differences(upper,strictly_lower,positive);
+		insert_differences(upper,lower,nonnegative);
+		remove_rows_with_too_many_ancestors(positive,first_new_positive);
+		remove_rows_with_too_many_ancestors(nonnegative,first_new_nonnegative);
+		positive.eliminate_duplicates();
+		nonnegative.eliminate_duplicates();
+		if (next_lp_redundancy_check>0 && positive.size()+nonnegative.size()>next_lp_redundancy_check) {
+			remove_rows_implied_by_others();
+			next_lp_redundancy_check=max(lp_redundancy_threshold,2*(positive.size()+nonnegative.size()));
+		}
+	}
+public:
+	RationalFourierMotzkin(const exvector& unknowns, const vector<RationalInequality>& inequalities) : unknowns{unknowns}, positive(unknowns.size()), nonnegative(unknowns.size()),
+		eliminated(unknowns.size()), original_rows(inequalities.size()) {
+		for (int i=0;i<inequalities.size();++i) insert(inequalities[i],i);
+		positive.eliminate_duplicates();
+		nonnegative.eliminate_duplicates();
+	}
+	//return true if the inequalities have a common solution, recording the bounds used to compute it; throws OutOfMemory if the system becomes too large
+	bool solve(IntermediateInequalities& intermediate_inequalities) {
+		while (true) {
+			if (!remove_constant_inequalities()) return false;
+			if (positive.empty() && nonnegative.empty()) break;
+			eliminate(variable_to_eliminate(),intermediate_inequalities);
+		}
+		//unknowns whose inequalities have been discarded along with the others can take any value, and are assigned first
+		for (int k=0;k<unknowns.size();++k)
+			if (!eliminated[k]) intermediate_inequalities.update(unknowns[k],{},{});
+		return true;
+	}
+};
+
 template<typename Variable>
 class LinearInequalities {
 	GenericLinearInequalities<GreaterThan,LessOrEqualThan> positive_;
@@ -258,6 +438,19 @@ class LinearInequalities {
 		insert_differences(comparable.compare_to_x,comparable.x_compares_to,nonnegative_);
 		nonnegative_.eliminate_duplicates();	
 	}
+	//true if x is the left-hand side of a nontrivial equation in subs, i.e. its value is determined by the other unknowns
+	bool is_dependent(ex x) const {
+		for (auto eq : subs)
+			if (eq.lhs()==x) return eq.lhs()!=eq.rhs();
+		return false;
+	}
+	//the unknowns that can be assigned a value freely, subject to the inequalities
+	exvector independent_unknowns() const {
+		exvector result;
+		for (auto& x: unknowns)
+			if (!is_dependent(x)) result.push_back(x);
+		return result;
+	}
 	void update_symbols() {
 		set<ex,ex_is_less> variables;
 		positive_.GetSymbols<Variable>(variables);
@@ -302,25 +495,56 @@ class LinearInequalities {
 			}
 	}
 
-	//applies the Fourier-Motzkin algorithm to determine whether the inequalities have a common solution
+	//applies the Fourier-Motzkin algorithm to determine whether the inequalities have a common solution; throws OutOfMemory if the system becomes too large
+	bool destructive_eliminate() {
+		//dependent unknowns do not appear in the inequalities, and are determined by complete_solution
+		auto variables=independent_unknowns();
+		if (auto rows=rational_inequalities(variables))
+			try {
+				IntermediateInequalities intermediate;
+				bool result=RationalFourierMotzkin{variables,*rows}.solve(intermediate);
+				if (!result || satisfies(complete_solution(intermediate.solution()))) {
+					intermediate_inequalities=move(intermediate);
+					return result;
+				}
+				cerr<<"redundancy elimination in linear inequalities produced an invalid solution; using symbolic coefficients"<<endl;
+			}
+			catch (const CoefficientOverflow&) {}	//use symbolic coefficients
+		if (!remove_constant_inequalities()) return false;
+		while (!empty()) {
+			if (!remove_constant_inequalities()) return false;
+			eliminate();
+		}
+		return true;
+	}
 	bool destructive_has_solution() {
 		try {
-				if (!remove_constant_inequalities()) return false;
-			while (!empty()) {
-				if (!remove_constant_inequalities()) return false;
-				eliminate();
-			}
+			return destructive_eliminate();
 		}
 		catch (const OutOfMemory& p) {
 			cerr<<"out of memory when solving linear inequalities (try a better algorithm!) "<<p.what()<<endl;
 			return false;
 		}
-		return true;
 	}
 	
-	lst destructive_find_solution()  {
-		if (!destructive_has_solution()) return  lst{};
-		auto solution_to_inequalities=intermediate_inequalities.solution() ;
+	//return false if some inequality evaluates to a number with the wrong sign, or some equation to a nonzero number
+	bool satisfies(const lst& solution) const {
+		for (auto eq : subs) {
+			ex value=(eq.lhs()-eq.rhs()).subs(solution);
+			if (is_a<numeric>(value) && !value.is_zero()) return false;
+		}
+		for (auto& x: positive_.list_of_inequalities()) {
+			ex value=x.subs(solution);
+			if (is_a<numeric>(value) && !ex_to<numeric>(value).is_positive()) return false;
+		}
+		for (auto& x: nonnegative_.list_of_inequalities()) {
+			ex value=x.subs(solution);
+			if (is_a<numeric>(value) && ex_to<numeric>(value).is_negative()) return false;
+		}
+		return true;
+	}
+	//extend a solution to the inequalities to a solution of the whole system
+	lst complete_solution(lst solution_to_inequalities) const {
 		assign_values_to_free_variables(solution_to_inequalities);
 		lst result=solution_to_inequalities;
 		for (auto eq : subs)
@@ -329,6 +553,46 @@ class LinearInequalities {
 		return result;
 	}
 
+	lst destructive_find_solution()  {
+		if (!destructive_has_solution()) return  lst{};
+		return complete_solution(intermediate_inequalities.solution());
+	}
+
+	//append the inequalities to rows, returning false if some coefficient is not a rational number
+	bool to_rational_inequalities(const list<ex>& inequalities, bool strict, const exvector& variables, vector<RationalInequality>& rows) const {
+		lst unknowns_to_zero;
+		for (auto& x: variables) unknowns_to_zero.append(x==0);
+		for (auto inequality : inequalities) {
+			inequality=inequality.expand();
+			RationalInequality row;
+			row.strict=strict;
+			ex constant=inequality.subs(unknowns_to_zero);
+			if (!is_a<numeric>(constant) || !ex_to<numeric>(constant).is_rational()) return false;
+			row.constant=ex_to<numeric>(constant);
+			for (auto& x: variables) {
+				ex coefficient=inequality.coeff(x);
+				if (!is_a<numeric>(coefficient) || !ex_to<numeric>(coefficient).is_rational()) return false;
+				row.coefficients.push_back(ex_to<numeric>(coefficient));
+			}
+			rows.push_back(move(row));
+		}
+		return true;
+	}
+	//the inequalities as rows of rational coefficients with respect to the given unknowns, or nullopt if they depend on other parameters
+	optional<vector<RationalInequality>> rational_inequalities(const exvector& variables) const {
+		vector<RationalInequality> rows;
+		if (!to_rational_inequalities(positive_.list_of_inequalities(),true,variables,rows) || !to_rational_inequalities(nonnegative_.list_of_inequalities(),false,variables,rows))
+			return nullopt;
+		return rows;
+	}
+	//the assignment of the coordinates of point to the given unknowns
+	static lst to_solution(const exvector& variables, const vector<numeric>& point) {
+		lst solution;
+		auto x=point.begin();
+		for (auto& unknown: variables) solution.append(unknown==*x++);
+		return solution;
+	}
+
 public:
 	template<typename Iterator>
 	LinearInequalities positive(Iterator begin, Iterator end) const {
@@ -369,10 +633,29 @@ public:
 	}
 
 	bool has_solution() const {
+		if (feasibility_algorithm==FeasibilityAlgorithm::SIMPLEX) {
+			auto variables=independent_unknowns();
+			if (auto rows=rational_inequalities(variables)) return simplex::feasible_point(*rows,variables.size()).has_value();
+		}
 		auto copy=*this;
 		return move(copy).destructive_has_solution();
 	}
 	lst find_solution() const {
+		if (feasibility_algorithm==FeasibilityAlgorithm::SIMPLEX) {
+			//dependent unknowns do not appear in the inequalities, and are determined by complete_solution
+			auto variables=independent_unknowns();
+			if (auto rows=rational_inequalities(variables)) {
+				auto point=simplex::feasible_point(*rows,variables.size());
+				if (!point) return lst{};
+				//the system has a solution; prefer the one given by Fourier-Motzkin, which lies in the interior and has smaller entries, unless it is too expensive to compute
+				auto copy=*this;
+				try {
+					if (copy.destructive_eliminate()) return copy.complete_solution(copy.intermediate_inequalities.solution());
+				}
+				catch (const OutOfMemory&) {}
+				return complete_solution(to_solution(variables,point.value()));
+			}
+		}
 		auto copy=*this;
 		return move(copy).destructive_find_solution();
 	}
@@ -402,48 +685,98 @@ ostream& operator<<(ostream& os, const LinearInequalities<T>& l) {
 	return os;
 }
 
-//represent a list of linear inequalities logically separated by an or, e.g. x<0 || x>0
+/** Represent a formula obtained from systems of linear inequalities with the connectives and, or, e.g. (x<0 || x>0) && y>0
+
+The formula is stored as a tree, which is not expanded in disjunctive normal form. To look for a solution, the tree is explored depth-first in the order of
+the disjunctive normal form: leaves are added to a partial conjunction, shared by all the branches that follow, and at each disjunction the branch is
+abandoned if the partial conjunction has no solution.
+*/
 template<typename Variable>
 class AlternativeLinearInequalities {
-	list<LinearInequalities<Variable>> alternatives;
+	enum class Connective {AND, OR};
+	struct Node {
+		Connective connective;
+		vector<shared_ptr<const Node>> children;
+		optional<LinearInequalities<Variable>> leaf;	//if set, the node is a leaf and children is empty
+	};
+	shared_ptr<const Node> root=make_shared<Node>(Node{Connective::OR,{},nullopt});	//an empty disjunction, i.e. false
+
+	AlternativeLinearInequalities(shared_ptr<const Node> root) : root{move(root)} {}
+	static AlternativeLinearInequalities leaf(const LinearInequalities<Variable>& ineq) {
+		return AlternativeLinearInequalities{make_shared<Node>(Node{Connective::AND,{},ineq})};
+	}
+	AlternativeLinearInequalities combine(Connective connective, shared_ptr<const Node> other) const {
+		Node result{connective,{},nullopt};
+		for (auto& node : {root,other})
+			if (!node->leaf && node->connective==connective) result.children.insert(result.children.end(),node->children.begin(),node->children.end());
+			else result.children.push_back(node);
+		return AlternativeLinearInequalities{make_shared<Node>(move(result))};
+	}
+	static LinearInequalities<Variable> conjunction(const LinearInequalities<Variable>& ineq, const LinearInequalities<Variable>& ineq2) {
+		return ineq.positive(ineq2.get_positive()).nonnegative(ineq2.get_nonnegative()).zero(ineq2.get_zero());
+	}
+	//explore the conjunctions of partial with the nodes in pending, the last of which is considered first, calling accept on each until it returns true
+	template<typename Accept>
+	static bool search(LinearInequalities<Variable> partial, vector<const Node*> pending, Accept&& accept) {
+		while (!pending.empty()) {
+			auto node=pending.back();
+			pending.pop_back();
+			if (node->leaf) partial=conjunction(partial,node->leaf.value());
+			else if (node->connective==Connective::AND)
+				for (auto child=node->children.rbegin();child!=node->children.rend();++child) pending.push_back(child->get());
+			else {
+				if (!partial.has_solution()) return false;
+				for (auto& child : node->children) {
+					auto branch=pending;
+					branch.push_back(child.get());
+					if (search(partial,move(branch),accept)) return true;
+				}
+				return false;
+			}
+		}
+		return accept(partial);
+	}
+	static list<LinearInequalities<Variable>> expand(const Node& node) {
+		if (node.leaf) return {node.leaf.value()};
+		list<LinearInequalities<Variable>> result;
+		if (node.connective==Connective::OR)
+			for (auto& child : node.children) result.splice(result.end(),expand(*child));
+		else {
+			result.emplace_back();
+			for (auto& child : node.children) {
+				list<LinearInequalities<Variable>> product;
+				auto alternatives=expand(*child);
+				for (auto& ineq : result)
+				for (auto& ineq2 : alternatives)
+					product.push_back(conjunction(ineq,ineq2));
+				result=move(product);
+			}
+		}
+		return result;
+	}
 public:	
+	AlternativeLinearInequalities()=default;
+	explicit AlternativeLinearInequalities(const LinearInequalities<Variable>& ineq) : root{leaf(ineq).root} {}
 	AlternativeLinearInequalities operator||(const AlternativeLinearInequalities& ineq) const {
-		auto result=*this;
-		result.alternatives.insert(result.alternatives.end(),ineq.alternatives.begin(),ineq.alternatives.end());
-		return result;
+		return combine(Connective::OR,ineq.root);
 	}
 	AlternativeLinearInequalities operator||(const LinearInequalities<Variable>& ineq) const {
-		auto result=*this;
-		result.alternatives.emplace_back(ineq);
-		return result;
+		return combine(Connective::OR,leaf(ineq).root);
 	}
 	AlternativeLinearInequalities operator&&(const AlternativeLinearInequalities<Variable>& other) const {
-		AlternativeLinearInequalities result;
-		for (auto& ineq : alternatives)
-		for (auto& ineq2 : other.alternatives)
-			result.alternatives.push_back(
-				ineq.positive(ineq2.get_positive()).nonnegative(ineq2.get_nonnegative()).zero(ineq2.get_zero())
-			);
-		return result;
+		return combine(Connective::AND,other.root);
 	}
 	AlternativeLinearInequalities operator&&(const LinearInequalities<Variable>& ineq) const {
-		AlternativeLinearInequalities result;
-		for (auto& x: alternatives)
-			result.alternatives.push_back(x.positive(ineq.get_positive()).nonnegative(ineq.get_nonnegative()).zero(ineq.get_zero()));
-		return result;
+		return combine(Connective::AND,leaf(ineq).root);
 	}
 	static AlternativeLinearInequalities positive(ex x)  {
-		AlternativeLinearInequalities result;	
-		result.alternatives.push_back(LinearInequalities<Variable>{}.positive(&x,&x+1));
-		return result;
+		return leaf(LinearInequalities<Variable>{}.positive(&x,&x+1));
 	}
 	static AlternativeLinearInequalities negative(ex x)  {
 		return positive(-x);		
 	}
 	static AlternativeLinearInequalities nonnegative(ex x)  {
-		AlternativeLinearInequalities result;
-		result.alternatives.push_back(LinearInequalities<Variable>{}.nonnegative(&x,&x+1));
-		return result;
+		return leaf(LinearInequalities<Variable>{}.nonnegative(&x,&x+1));
 	}
 	static AlternativeLinearInequalities nonpositive(ex x)  {
 		return nonnegative(-x);
@@ -452,31 +785,31 @@ public:
 		return positive(x) || negative(x);
 	}
 	static AlternativeLinearInequalities zero(ex x)  {
-		AlternativeLinearInequalities result;
-		result.alternatives.push_back(LinearInequalities<Variable>{}.zero(&x,&x+1));
-		return result;
+		return leaf(LinearInequalities<Variable>{}.zero(&x,&x+1));
 	}
 	bool has_solution() const {
-		return any_of(alternatives.begin(), alternatives.end(),
-			[] (auto& ineq) {return ineq.has_solution();});
+		return search({},{root.get()},[] (auto& ineq) {return ineq.has_solution();});
 	}
 	lst find_solution() const {
-		for (auto& ineq : alternatives) {			
-			auto sol=ineq.find_solution();
-			if (sol.nops()) return sol;
-		}
-		return {};
+		lst sol;
+		search({},{root.get()},[&sol] (auto& ineq) {
+			sol=ineq.find_solution();
+			return sol.nops()!=0;
+		});
+		return sol;
+	}
+	//the alternatives in disjunctive normal form; their number may be exponential in the size of the formula
+	list<LinearInequalities<Variable>> alternatives() const {
+		return expand(*root);
 	}
-	auto alternative_begin() const {return alternatives.begin();}
-	auto alternative_end() const {return alternatives.end();}
 };
 
 template<typename Variable>
-ostream& operator<<(ostream& os, AlternativeLinearInequalities <Variable>& alts) {
+ostream& operator<<(ostream& os, const AlternativeLinearInequalities <Variable>& alts) {
 	bool first=true;
-	for (auto i=alts.alternative_begin();i!=alts.alternative_end();++i) {
+	for (auto& alternative: alts.alternatives()) {
 		if (!first) os<<"\t|| ";
-		os<<*i<<endl;
+		os<<alternative<<endl;
 		first=false;		
 	}
 	return os;
@@ -0,0 +1,177 @@
+#ifndef MODULARRICCI_H
+#define MODULARRICCI_H
+
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+
+//arithmetic modulo the prime 2^61-1
+namespace modular {
+	const uint64_t p=(uint64_t{1}<<61)-1;
+	uint64_t add(uint64_t a, uint64_t b) {return (a+b)%p;}
+	uint64_t sub(uint64_t a, uint64_t b) {return (a+p-b)%p;}
+	uint64_t mul(uint64_t a, uint64_t b) {return static_cast<unsigned __int128>(a)*b%p;}
+	uint64_t pow(uint64_t a, uint64_t e) {
+		uint64_t result=1;
+		for (;e;e>>=1, a=mul(a,a))
+			if (e&1) result=mul(result,a);
+		return result;
+	}
+	uint64_t inverse(uint64_t a) {return pow(a,p-2);}
+	//the residue of a rational number, or nullopt if its denominator is divisible by p
+	optional<uint64_t> residue(const numeric& x) {
+		assert(x.is_rational());
+		numeric modulus{static_cast<long>(p)};
+		auto numerator=mod(x.numer(),modulus).to_long(), denominator=mod(x.denom(),modulus).to_long();
+		if (!denominator) return nullopt;
+		return mul(numerator,inverse(denominator));
+	}
+
+	//invert an n by n matrix stored by rows; return false if it is singular
+	bool invert(vector<uint64_t>& m, int n) {
+		vector<uint64_t> inverse_(n*n);
+		for (int i=0;i<n;++i) inverse_[i*n+i]=1;
+		for (int column=0;column<n;++column) {
+			int pivot=column;
+			while (pivot<n && !m[pivot*n+column]) ++pivot;
+			if (pivot==n) return false;
+			for (int j=0;j<n;++j) {
+				swap(m[pivot*n+j],m[column*n+j]);
+				swap(inverse_[pivot*n+j],inverse_[column*n+j]);
+			}
+			auto a=inverse(m[column*n+column]);
+			for (int j=0;j<n;++j) {
+				m[column*n+j]=mul(m[column*n+j],a);
+				inverse_[column*n+j]=mul(inverse_[column*n+j],a);
+			}
+			for (int i=0;i<n;++i) {
+				if (i==column || !m[i*n+column]) continue;
+				auto b=m[i*n+column];
+				for (int j=0;j<n;++j) {
+					m[i*n+j]=sub(m[i*n+j],mul(b,m[column*n+j]));
+					inverse_[i*n+j]=sub(inverse_[i*n+j],mul(b,inverse_[column*n+j]));
+				}
+			}
+		}
+		m=move(inverse_);
+		return true;
+	}
+}
+
+/** Computes the Ricci endomorphism Ric=g^{-1}ric of left-invariant metrics on a Lie algebra at random points, modulo the prime 2^61-1.
+
+This is only possible when the structure constants are rational. Evaluating at a point modulo p does not distinguish entries that happen to take the same
+value, but entries that take different values are certainly different; hence, the number of distinct nonzero values gives a lower bound for the number of
+distinct nonzero entries of the Ricci endomorphism computed symbolically. Random points are generated with a fixed seed, so that results are reproducible.
+*/
+class ModularRicci {
+	int n;
+	vector<uint64_t> c;		//c[(i*n+j)*n+k] is the component of [e_i,e_j] along e_k, up to a global sign which does not affect the curvature
+	std::mt19937_64 random{1};
+
+	ModularRicci(int n) : n{n}, c(n*n*n) {}
+	uint64_t bracket(int i, int j, int k) const {return c[(i*n+j)*n+k];}
+	//the Ricci endomorphism relative to the metric with matrix g on the basis, stored by rows, or nullopt if g is singular
+	optional<vector<uint64_t>> ricci(const vector<uint64_t>& g) const {
+		using namespace modular;
+		auto g_inverse=g;
+		if (!invert(g_inverse,n)) return nullopt;
+		auto half=inverse(2);
+		//Koszul formula: 2g(\nabla_{e_i}e_j,e_l)=g([e_i,e_j],e_l)-g([e_j,e_l],e_i)+g([e_l,e_i],e_j)
+		vector<uint64_t> koszul(n*n*n), gamma(n*n*n);	//\nabla_{e_i}e_j=\sum_m gamma[(i*n+j)*n+m]e_m
+		for (int i=0;i<n;++i)
+		for (int j=0;j<n;++j)
+		for (int l=0;l<n;++l) {
+			uint64_t x=0;
+			for (int k=0;k<n;++k) {
+				x=add(x,mul(bracket(i,j,k),g[k*n+l]));
+				x=sub(x,mul(bracket(j,l,k),g[k*n+i]));
+				x=add(x,mul(bracket(l,i,k),g[k*n+j]));
+			}
+			koszul[(i*n+j)*n+l]=mul(x,half);
+		}
+		for (int i=0;i<n;++i)
+		for (int j=0;j<n;++j)
+		for (int m=0;m<n;++m) {
+			uint64_t x=0;
+			for (int l=0;l<n;++l) x=add(x,mul(koszul[(i*n+j)*n+l],g_inverse[l*n+m]));
+			gamma[(i*n+j)*n+m]=x;
+		}
+		auto Gamma=[&gamma,this] (int i, int j, int m) {return gamma[(i*n+j)*n+m];};
+		//ric(e_b,e_c) is the trace of e_a\mapsto R(e_a,e_b)e_c=\nabla_a\nabla_b e_c-\nabla_b\nabla_a e_c-\nabla_{[e_a,e_b]}e_c
+		vector<uint64_t> trace(n);
+		for (int m=0;m<n;++m)
+			for (int a=0;a<n;++a) trace[m]=add(trace[m],Gamma(a,m,a));
+		vector<uint64_t> ric(n*n);
+		for (int b=0;b<n;++b)
+		for (int c=0;c<n;++c) {
+			uint64_t x=0;
+			for (int m=0;m<n;++m) x=add(x,mul(Gamma(b,c,m),trace[m]));
+			for (int a=0;a<n;++a)
+			for (int m=0;m<n;++m) x=sub(x,mul(Gamma(a,c,m),Gamma(b,m,a)));
+			for (int a=0;a<n;++a)
+			for (int k=0;k<n;++k) x=sub(x,mul(bracket(a,b,k),Gamma(k,c,a)));
+			ric[b*n+c]=x;
+		}
+		vector<uint64_t> Ric(n*n);
+		for (int i=0;i<n;++i)
+		for (int j=0;j<n;++j)
+			for (int k=0;k<n;++k) Ric[i*n+j]=add(Ric[i*n+j],mul(g_inverse[i*n+k],ric[k*n+j]));
+		return Ric;
+	}
+	//evaluate a matrix whose entries are rational numbers or symbols at a random point; return nullopt if an entry is of a different type
+	optional<vector<uint64_t>> random_point(const matrix& g) {
+		map<ex,uint64_t,ex_is_less> values;
+		vector<uint64_t> result;
+		for (int i=0;i<n;++i)
+		for (int j=0;j<n;++j) {
+			ex x=g(i,j);
+			if (is_a<symbol>(x)) {
+				auto& value=values[x];
+				if (!value) value=1+random()%(modular::p-1);
+				result.push_back(value);
+			}
+			else if (is_a<numeric>(x) && ex_to<numeric>(x).is_rational()) {
+				auto value=modular::residue(ex_to<numeric>(x));
+				if (!value) return nullopt;
+				result.push_back(value.value());
+			}
+			else return nullopt;
+		}
+		return result;
+	}
+public:
+	//return nullopt if the structure constants are not all rational, or the Lie algebra is too large
+	static optional<ModularRicci> from(const StructureConstants& constants) {
+		int n=constants.dimension();
+		ModularRicci result{n};
+		for (int k=0;k<n;++k)
+		for (auto entry=constants.begin(k);entry!=constants.end(k);++entry) {
+			if (!is_a<numeric>(entry->c) || !ex_to<numeric>(entry->c).is_rational()) return nullopt;
+			auto c=modular::residue(ex_to<numeric>(entry->c));
+			if (!c) return nullopt;
+			result.c[(entry->i*n+entry->j)*n+k]=c.value();
+			result.c[(entry->j*n+entry->i)*n+k]=modular::sub(0,c.value());
+		}
+		return result;
+	}
+	/** A lower bound for the number of distinct nonzero entries of Ric=g^{-1}ric, computed symbolically as a function of the metric parameters.
+	@param g The matrix of a left-invariant metric relative to the basis, whose entries are symbols or rational numbers
+	@param points The number of random points to try
+	*/
+	int lower_bound_on_distinct_entries(const matrix& g, int points=2) {
+		int result=0;
+		for (int attempt=0;attempt<points;++attempt) {
+			auto g_at_point=random_point(g);
+			if (!g_at_point) return 0;
+			auto Ric=ricci(g_at_point.value());
+			if (!Ric) continue;
+			std::unordered_set<uint64_t> values(Ric->begin(),Ric->end());
+			values.erase(0);
+			result=max<int>(result,values.size());
+		}
+		return result;
+	}
+};
+
+#endif
@@ -103,6 +103,11 @@ public:
 		for (auto& couple : couples) node=apply(node,couple);
 		return node;	
 	}
+	vector<int> as_permutation() const {
+		vector<int> result;
+		for (int i=0;i<n;++i) result.push_back(apply(i));
+		return result;
+	}
 	string to_string() const {
 		string result;
 		for (auto c: couples) result+="("+std::to_string(c.first+1)+" "+std::to_string(c.second+1)+")";
@@ -152,6 +157,7 @@ public:
 		return *this;
 	}
 	matrix operator*() const {return sigma.sigma_diagonal_metric(coefficients);}	
+	const OrderTwoAutomorphism& automorphism() const {return sigma;}
 
 	static SigmaDiagonalMetricIterator begin(int n) {
 		SigmaDiagonalMetricIterator result;	
@@ -185,4 +191,72 @@ public:
 	auto end() const {
 		return SigmaDiagonalMetricIterator::end(n);
 	}
-};
\ No newline at end of file
+};
+
+//the algorithm used to compute the Ricci tensor of sigma-diagonal metrics
+enum class RicciAlgorithm {
+	STRUCTURE_CONSTANTS, GENERIC, CROSS_CHECK
+};
+
+RicciAlgorithm ricci_algorithm=RicciAlgorithm::STRUCTURE_CONSTANTS;
+
+struct RicciTensors {
+	matrix ric;	//the Ricci tensor
+	matrix Ric;	//the Ricci endomorphism g^{-1}ric
+};
+
+/** Compute the Ricci tensor of a metric whose matrix relative to the basis has exactly one nonzero entry in each row, such as a sigma-diagonal metric, directly from the structure constants.
+
+Write g(e_i,e_j)=h_i\delta_{j\sigma(i)}, where sigma is an involution and h_{\sigma(i)}=h_i, and denote by c_{ij}^k the structure constants. Then g^{-1}(e^i,e^j)=\delta_{j\sigma(i)}/h_i
+and the Christoffel symbols are \Gamma_{ij}^m=(c_{ij}^m h_m-c_{j\sigma(m)}^{\sigma(i)}h_i+c_{\sigma(m)i}^{\sigma(j)}h_j)/2h_m, so the Ricci tensor is a sum over the nonzero
+structure constants which involves no matrix algebra. The entries are returned in normal form. Return nullopt if g is not of this form.
+*/
+optional<RicciTensors> ricci_of_sigma_diagonal_metric(const StructureConstants& c, const matrix& g) {
+	int n=c.dimension();
+	vector<int> sigma(n);
+	exvector h(n);
+	for (int i=0;i<n;++i) {
+		int nonzero=0;
+		for (int j=0;j<n;++j)
+			if (!g(i,j).is_zero()) {
+				sigma[i]=j;
+				++nonzero;
+			}
+		if (nonzero!=1) return nullopt;
+		h[i]=g(i,sigma[i]);
+	}
+	for (int i=0;i<n;++i)
+		if (sigma[sigma[i]]!=i || h[sigma[i]]!=h[i]) return nullopt;
+	exvector bracket(n*n*n);	//the structure constants, up to a global sign which does not affect the curvature
+	for (int k=0;k<n;++k)
+	for (auto entry=c.begin(k);entry!=c.end(k);++entry) {
+		bracket[(entry->i*n+entry->j)*n+k]=entry->c;
+		bracket[(entry->j*n+entry->i)*n+k]=-entry->c;
+	}
+	auto C=[&bracket,n] (int i, int j, int k) -> const ex& {return bracket[(i*n+j)*n+k];};
+	exvector gamma(n*n*n);
+	for (int i=0;i<n;++i)
+	for (int j=0;j<n;++j)
+	for (int m=0;m<n;++m)
+		gamma[(i*n+j)*n+m]=(C(i,j,m)*h[m]-C(j,sigma[m],sigma[i])*h[i]+C(sigma[m],i,sigma[j])*h[j])/(2*h[m]);
+	auto Gamma=[&gamma,n] (int i, int j, int m) -> const ex& {return gamma[(i*n+j)*n+m];};
+	//ric(e_b,e_c) is the trace of e_a\mapsto R(e_a,e_b)e_c=\nabla_a\nabla_b e_c-\nabla_b\nabla_a e_c-\nabla_{[e_a,e_b]}e_c
+	exvector trace(n);
+	for (int m=0;m<n;++m)
+		for (int a=0;a<n;++a) trace[m]+=Gamma(a,m,a);
+	RicciTensors result{matrix(n,n),matrix(n,n)};
+	for (int b=0;b<n;++b)
+	for (int c=0;c<n;++c) {
+		ex x;
+		for (int m=0;m<n;++m) x+=Gamma(b,c,m)*trace[m];
+		for (int a=0;a<n;++a)
+		for (int m=0;m<n;++m) x-=Gamma(a,c,m)*Gamma(b,m,a);
+		for (int a=0;a<n;++a)
+		for (int k=0;k<n;++k) x-=C(a,b,k)*Gamma(k,c,a);
+		result.ric(b,c)=x.normal();
+	}
+	for (int i=0;i<n;++i)
+	for (int j=0;j<n;++j)
+		result.Ric(i,j)=(result.ric(sigma[i],j)/h[i]).normal();
+	return result;
+}
@@ -0,0 +1,215 @@
+#ifndef SIMPLEX_H
+#define SIMPLEX_H
+
+#include <vector>
+#include <optional>
+#include <cmath>
+
+using namespace GiNaC;
+
+//an inequality a.x+c>0 or a.x+c>=0 in rational unknowns x
+struct RationalInequality {
+	vector<numeric> coefficients;
+	numeric constant;
+	bool strict;
+};
+
+namespace simplex {
+
+bool is_positive(double x) {return x>1e-9;}
+bool is_negative(double x) {return x<-1e-9;}
+bool is_nonzero(double x) {return std::abs(x)>1e-9;}
+bool is_positive(const numeric& x) {return x.is_positive();}
+bool is_negative(const numeric& x) {return x.is_negative();}
+bool is_nonzero(const numeric& x) {return !x.is_zero();}
+double to(double, const numeric& x) {return x.to_double();}
+numeric to(const numeric&, const numeric& x) {return x;}
+
+/** A linear program max c.x subject to Ax<=b, x>=0, in the slack form of Cormen, Leiserson, Rivest and Stein, Introduction to Algorithms, Chapter 29.
+
+Each basic variable is expressed as x_{basic[i]}=b[i]-\sum_j A[i][j] x_{nonbasic[j]}, and the objective as v+\sum_j c[j] x_{nonbasic[j]}. Pivots are chosen
+with Bland's rule, so the algorithm terminates in exact arithmetic; with T=double, the number of pivots is bounded and tolerances are used in comparisons.
+*/
+template<typename T>
+class Tableau {
+	vector<vector<T>> A;
+	vector<T> b, c;
+	T v{};
+	vector<int> basic, nonbasic;
+	int variables;		//number of original variables, followed by the slack variables
+
+	int column_of(int variable) const {return find(nonbasic.begin(),nonbasic.end(),variable)-nonbasic.begin();}
+	int row_of(int variable) const {return find(basic.begin(),basic.end(),variable)-basic.begin();}
+
+	void pivot(int leaving, int entering) {
+		auto& pivot_row=A[leaving];
+		T a=pivot_row[entering];
+		b[leaving]=b[leaving]/a;
+		for (int j=0;j<nonbasic.size();++j)
+			if (j!=entering) pivot_row[j]=pivot_row[j]/a;
+		pivot_row[entering]=T{1}/a;
+		for (int i=0;i<basic.size();++i) {
+			if (i==leaving) continue;
+			T coefficient=A[i][entering];
+			if (!is_nonzero(coefficient)) continue;
+			b[i]=b[i]-coefficient*b[leaving];
+			for (int j=0;j<nonbasic.size();++j)
+				if (j!=entering) A[i][j]=A[i][j]-coefficient*pivot_row[j];
+			A[i][entering]=-coefficient*pivot_row[entering];
+		}
+		T coefficient=c[entering];
+		v=v+coefficient*b[leaving];
+		for (int j=0;j<nonbasic.size();++j)
+			if (j!=entering) c[j]=c[j]-coefficient*pivot_row[j];
+		c[entering]=-coefficient*pivot_row[entering];
+		swap(basic[leaving],nonbasic[entering]);
+	}
+	//return false if the program is unbounded or the maximum number of pivots is reached
+	bool optimize(int max_pivots) {
+		while (max_pivots--) {
+			int entering=-1;
+			for (int j=0;j<nonbasic.size();++j)
+				if (is_positive(c[j]) && (entering<0 || nonbasic[j]<nonbasic[entering])) entering=j;
+			if (entering<0) return true;
+			int leaving=-1;
+			T min_ratio{};
+			for (int i=0;i<basic.size();++i) {
+				if (!is_positive(A[i][entering])) continue;
+				T ratio=b[i]/A[i][entering];
+				if (leaving<0 || is_negative(ratio-min_ratio) || (!is_positive(ratio-min_ratio) && basic[i]<basic[leaving])) {
+					leaving=i;
+					min_ratio=ratio;
+				}
+			}
+			if (leaving<0) return false;
+			pivot(leaving,entering);
+		}
+		return false;
+	}
+public:
+	template<typename Matrix, typename Vector>
+	Tableau(const Matrix& A, const Vector& b, const Vector& c) : variables(c.size()) {
+		for (auto& row: A) {
+			this->A.emplace_back();
+			for (auto& x: row) this->A.back().push_back(to(T{},x));
+		}
+		for (auto& x: b) this->b.push_back(to(T{},x));
+		for (auto& x: c) this->c.push_back(to(T{},x));
+		for (int j=0;j<variables;++j) nonbasic.push_back(j);
+		for (int i=0;i<b.size();++i) basic.push_back(variables+i);
+	}
+	//return false if the feasible region is empty
+	bool make_feasible(int max_pivots) {
+		auto most_negative=min_element(b.begin(),b.end(),[] (const T& x, const T& y) {return is_negative(x-y);})-b.begin();
+		if (most_negative==b.size() || !is_negative(b[most_negative])) return true;
+		//solve the auxiliary program max -x0 subject to Ax-x0<=b
+		int x0=variables+basic.size();
+		auto c=move(this->c);
+		auto v=this->v;
+		this->c=vector<T>(nonbasic.size(),T{});
+		this->c.push_back(T{-1});
+		this->v=T{};
+		for (auto& row: A) row.push_back(T{-1});
+		nonbasic.push_back(x0);
+		pivot(most_negative,nonbasic.size()-1);
+		if (!optimize(max_pivots) || is_negative(this->v)) return false;
+		int row=row_of(x0);
+		if (row<basic.size()) {
+			int entering=0;
+			while (entering<nonbasic.size() && !is_nonzero(A[row][entering])) ++entering;
+			if (entering==nonbasic.size()) return false;	//only possible because of rounding errors
+			pivot(row,entering);
+		}
+		int column=column_of(x0);
+		for (auto& row: A) row.erase(row.begin()+column);
+		nonbasic.erase(nonbasic.begin()+column);
+		//express the original objective in terms of the current nonbasic variables
+		this->c=vector<T>(nonbasic.size(),T{});
+		this->v=v;
+		for (int variable=0;variable<c.size();++variable) {
+			if (!is_nonzero(c[variable])) continue;
+			int column=column_of(variable);
+			if (column<nonbasic.size()) this->c[column]=this->c[column]+c[variable];
+			else {
+				int row=row_of(variable);
+				this->v=this->v+c[variable]*b[row];
+				for (int j=0;j<nonbasic.size();++j) this->c[j]=this->c[j]-c[variable]*A[row][j];
+			}
+		}
+		return true;
+	}
+	//pivot the variables in the given set into the basis; return false if it is not possible
+	bool crash(const vector<int>& target_basis) {
+		for (int variable : target_basis) {
+			int entering=column_of(variable);
+			if (entering==nonbasic.size()) continue;
+			int leaving=0;
+			while (leaving<basic.size() && (!is_nonzero(A[leaving][entering]) || find(target_basis.begin(),target_basis.end(),basic[leaving])!=target_basis.end())) ++leaving;
+			if (leaving==basic.size()) return false;
+			pivot(leaving,entering);
+		}
+		return true;
+	}
+	bool is_feasible() const {
+		return none_of(b.begin(),b.end(),[] (const T& x) {return is_negative(x);});
+	}
+	//solve the program assuming it is bounded; return false if the feasible region is empty or the maximum number of pivots is reached
+	bool solve(int max_pivots=numeric_limits<int>::max()) {
+		return make_feasible(max_pivots) && optimize(max_pivots);
+	}
+	bool resume(int max_pivots=numeric_limits<int>::max()) {
+		return optimize(max_pivots);
+	}
+	vector<int> basis() const {return basic;}
+	T value() const {return v;}
+	T value(int variable) const {
+		int row=row_of(variable);
+		return row<basic.size()? b[row] : T{};
+	}
+};
+
+/** Find a point satisfying a system of linear inequalities, strict or not, or return nullopt if there is none.
+
+Unknowns are written as differences of nonnegative variables, and strict inequalities a.x+c>0 are replaced by a.x+c>=t; the point is a vertex
+maximizing t<=1, so the system has a solution if and only if the maximum is positive. The linear program is first solved in floating point arithmetic;
+the optimal basis is then recomputed and verified in exact rational arithmetic, and the exact simplex algorithm is run from it, or from scratch if the
+basis turns out not to be feasible, so that the answer is always exact.
+*/
+optional<vector<numeric>> feasible_point(const vector<RationalInequality>& inequalities, int unknowns) {
+	int n=unknowns, t=2*n;
+	vector<vector<numeric>> A;
+	vector<numeric> b, c(2*n+1);
+	c[t]=1;
+	for (auto& inequality : inequalities) {
+		assert(inequality.coefficients.size()==n);
+		vector<numeric> row(2*n+1);
+		for (int j=0;j<n;++j) {
+			row[j]=-inequality.coefficients[j];
+			row[n+j]=inequality.coefficients[j];
+		}
+		if (inequality.strict) row[t]=1;
+		A.push_back(move(row));
+		b.push_back(inequality.constant);
+	}
+	vector<numeric> t_at_most_one(2*n+1);
+	t_at_most_one[t]=1;
+	A.push_back(move(t_at_most_one));
+	b.push_back(1);
+
+	Tableau<numeric> exact{A,b,c};
+	Tableau<double> approximate{A,b,c};
+	int max_pivots=50*(A.size()+c.size());
+	if (approximate.solve(max_pivots) && exact.crash(approximate.basis()) && exact.is_feasible()) exact.resume();
+	else {
+		exact=Tableau<numeric>{A,b,c};
+		if (!exact.solve()) return nullopt;
+	}
+	bool has_strict_inequalities=any_of(inequalities.begin(),inequalities.end(),[] (auto& inequality) {return inequality.strict;});
+	if (has_strict_inequalities && !exact.value().is_positive()) return nullopt;
+	vector<numeric> point;
+	for (int j=0;j<n;++j) point.push_back(exact.value(j)-exact.value(n+j));
+	return point;
+}
+
+}
+#endif
@@ -4,13 +4,20 @@
 #include "linearsolve.h"
 #include "derivations.h"
 #include "classification.h"
+#include "sigmadiagonal.h"
+#include "workspace.h"
 #include "torusinder.h"
 #include "graded.h"
 #include "linearextensions.h"
 #include "linearinequalities.h"
 #include "filtered.h"
 #include "antidiagonal.h"
-#include "sigmadiagonal.h"
+#include "modularricci.h"
+#include "automorphisms.h"
+#include "sweep.h"
+#include "workqueue.h"
+#include "cache.h"
+#include "idealcache.h"
 
 
 matrix ricci_tensor(const Manifold& G, matrix metric_on_frame) {
@@ -21,21 +28,44 @@ matrix ricci_tensor(const Manifold& G, matrix metric_on_frame) {
 	assert(ricci_tensor.rows()==G.Dimension());
 	return ricci_tensor;
 }
-   
+
+//the Ricci tensor and endomorphism of a left-invariant metric, computed according to ricci_algorithm
+RicciTensors ricci_tensors(const LieGroup& G, const StructureConstants& c, const matrix& g) {
+	optional<RicciTensors> from_structure_constants;
+	if (ricci_algorithm!=RicciAlgorithm::GENERIC) from_structure_constants=ricci_of_sigma_diagonal_metric(c,g);
+	if (from_structure_constants && ricci_algorithm==RicciAlgorithm::STRUCTURE_CONSTANTS) return from_structure_constants.value();
+	auto ric=ricci_tensor(G,g);
+	RicciTensors generic{ric,ex_to<matrix>((g.inverse()*ric).evalm())};
+	if (from_structure_constants)
+		for (int i=0;i<g.rows();++i)
+		for (int j=0;j<g.cols();++j)
+			if (!(generic.Ric(i,j)-from_structure_constants->Ric(i,j)).normal().is_zero())
+				throw logic_error("Ricci tensor computed from structure constants differs from generic computation at entry ("+to_string(i+1)+","+to_string(j+1)+")");
+	return generic;
+}
+
 struct MetricAndRicci {	
 	matrix g;
 	ex ric;
 	ex Ric;	
 	int score=std::numeric_limits<int>::max();
 	MetricAndRicci()=default;	
-	MetricAndRicci(const LieGroup& G, const matrix& g) : g{g}, ric {ricci_tensor(G,g)}, Ric{(g.inverse()*ric).evalm()} {
+	MetricAndRicci(const LieGroup& G, const StructureConstants& c, const matrix& g) : MetricAndRicci{g,ricci_tensors(G,c,g)} {}
+	exvector reduced_ideal() const {		
+		return ideal_cache.ideal_reduce(symbols,ideal);
+	}
+	bool no_solution() const {return score>=100;}
+private:
+	exvector symbols;
+	exvector ideal;
+	MetricAndRicci(const matrix& g, const RicciTensors& tensors) : g{g}, ric{tensors.ric}, Ric{tensors.Ric} {
 		static CocoaPolyAlgorithms::Initializer initialize_cocoa;
 		set<ex,ex_is_less> entries(begin(Ric),end(Ric));				
 		GetSymbols<symbol>(symbols,entries.begin(),entries.end());
 		for (auto& x: entries) if (!x.is_zero()) ideal.push_back(x.numer());
 		score=ideal.size();
 		try {
-		if (CocoaPolyAlgorithms_R::RadicalContains<symbol>(symbols, ideal.begin(),ideal.end(),g.determinant())) score+=100;
+		if (ideal_cache.radical_contains(symbols,ideal,g.determinant())) score+=100;
 		}
 		 catch (const CoCoA::ErrorInfo& err)
 		 {
@@ -43,13 +73,6 @@ struct MetricAndRicci {
 			throw err;
 		 }  
 	}
-	exvector reduced_ideal() const {		
-		return CocoaPolyAlgorithms_R::IdealReduce<symbol>(symbols, ideal.begin(),ideal.end());
-	}
-	bool no_solution() const {return score>=100;}
-private:
-	exvector symbols;
-	exvector ideal;
 };
 
 
@@ -77,21 +100,78 @@ ostream& operator<<(ostream& os, const MetricAndRicci& m ) {
 }
 
 
-struct FindMetricParameters {
-	vector<matrix> imaginary_derivations_in_torus;
-	optional<exvector> grading;
-	FindMetricParameters(const exvector& v) : grading{v} {}
-	FindMetricParameters(const TorusInDer& t) : imaginary_derivations_in_torus{t.imaginary_derivations_in_torus()} , grading{t.grading()} {}	
+//the data passed to the functions looking for metrics; when obtained from a TorusInDer, the torus is only computed if a function asks for it.
+//The structure constants are computed once for each row, and shared by all the functions that use them
+class FindMetricParameters {
+	const StructureConstants* structure_constants;
+	optional<exvector> grading_;
+	const TorusInDer* torus=nullptr;
+public:
+	FindMetricParameters(const StructureConstants& c, const exvector& v) : structure_constants{&c}, grading_{v} {}
+	FindMetricParameters(const TorusInDer& t) : structure_constants{&t.constants()}, torus{&t} {}
+	const StructureConstants& constants() const {return *structure_constants;}
+	optional<exvector> grading() const {return torus? torus->grading() : grading_;}
+	vector<matrix> imaginary_derivations_in_torus() const {return torus? torus->imaginary_derivations_in_torus() : vector<matrix>{};}
 };
 
-MetricAndRicci best_sigmadiagonal_metric(const LieGroup& G, const FindMetricParameters&) {
-	MetricAndRicci best;		
-	for (auto g: SigmaDiagonalMetrics{G.Dimension()}) {			
-		MetricAndRicci metric_and_ricci(G,g);
-		if (metric_and_ricci.score==0) 
-			return metric_and_ricci;				
-		else if (metric_and_ricci.score<best.score) best=metric_and_ricci;
-	}	
+//number of worker processes used to compute the scores of sigma-diagonal metrics on a single Lie algebra
+int involution_jobs=1;
+
+//return the first sigma-diagonal metric with the lowest score. Involutions conjugate under a permutation of the basis which induces an automorphism up to
+//sign give equivalent metrics, so only the first in each class is considered. Lower bounds on the scores are computed modulo a prime, and metrics are
+//examined in order of increasing lower bound, so that the score is only computed symbolically for metrics that can improve on the best metric found so far.
+//If involution_jobs>1, scores are computed by a pool of worker processes, and workers computing scores that cannot improve on the best are cancelled
+MetricAndRicci best_sigmadiagonal_metric(const LieGroup& G, const FindMetricParameters& p) {
+	auto& workspace=Workspace::of_dimension(G.Dimension());
+	auto& metrics=workspace.sigma_diagonal_metrics();
+	auto& involutions=workspace.involutions();
+	auto& structure_constants=p.constants();
+	auto representative=first_in_orbit(involutions,PermutationAutomorphisms{structure_constants}.permutations());
+	vector<pair<int,int>> lower_bound_and_index;
+	auto modular_ricci=ModularRicci::from(structure_constants);
+	for (int i=0;i<metrics.size();++i)
+		if (representative[i])
+			lower_bound_and_index.emplace_back(modular_ricci? modular_ricci->lower_bound_on_distinct_entries(metrics[i]) : 0,i);
+	sort(lower_bound_and_index.begin(),lower_bound_and_index.end());
+	MetricAndRicci best;
+	int best_index=-1;
+	if (involution_jobs<=1) {
+		for (auto [lower_bound,i] : lower_bound_and_index) {
+			if (make_pair(lower_bound,i)>make_pair(best.score,best_index)) break;
+			MetricAndRicci metric_and_ricci(G,structure_constants,metrics[i]);
+			if (make_pair(metric_and_ricci.score,i)<make_pair(best.score,best_index)) {
+				best=metric_and_ricci;
+				best_index=i;
+			}
+		}
+		return best;
+	}
+	int best_score=best.score;
+	auto cannot_improve=[&best_score,&best_index] (int lower_bound, int i) {return make_pair(lower_bound,i)>make_pair(best_score,best_index);};
+	WorkerPool pool{involution_jobs,[&G,&structure_constants,&metrics] (int i) {return to_string(MetricAndRicci{G,structure_constants,metrics[i]}.score);}};
+	map<int,int> lower_bound_of_submitted;
+	auto next=lower_bound_and_index.begin();
+	while (true) {
+		for (;pool.has_idle_worker() && next!=lower_bound_and_index.end() && !cannot_improve(next->first,next->second);++next) {
+			pool.submit(next->second);
+			lower_bound_of_submitted[next->second]=next->first;
+		}
+		if (!pool.busy()) break;
+		auto result=pool.next_result();
+		lower_bound_of_submitted.erase(result.task);
+		int score=stoi(result.output);
+		if (make_pair(score,result.task)<make_pair(best_score,best_index)) {
+			best_score=score;
+			best_index=result.task;
+		}
+		for (auto submitted=lower_bound_of_submitted.begin();submitted!=lower_bound_of_submitted.end();)
+			if (cannot_improve(submitted->second,submitted->first)) {
+				pool.cancel(submitted->first);
+				submitted=lower_bound_of_submitted.erase(submitted);
+			}
+			else ++submitted;
+	}
+	if (best_index>=0) best=MetricAndRicci{G,structure_constants,metrics[best_index]};
 	return best;
 }
 bool find_sigmadiagonal_metric(const LieGroup& G, const FindMetricParameters& p,ostream& os) {
@@ -102,7 +182,7 @@ bool find_sigmadiagonal_metric(const LieGroup& G, const FindMetricParameters& p,
 
 
 bool find_filtered_metric(const LieGroup& G,  const FindMetricParameters& p, ostream& os) {	
-	for (Filtration f{G}; f; ++f) {
+	for (Filtration f{G,p.constants()}; f; ++f) {
 		os<<horizontal(f.basis())<<"&"<<horizontal(f.weights());
 		os<<"\\\\"<<endl;			
 		return true;
@@ -118,39 +198,63 @@ exvector adapted_basis_from_indices(const exvector& e, const vector<int>& indice
 }
 
 bool find_foad_metric(const LieGroup& G, const FindMetricParameters& p,ostream& os) {	
-	if (p.grading) {	
-		auto sequences=WeightSequencesRespectingOrder{p.grading.value()};	
+	auto grading=p.grading();
+	if (grading) {	
+		auto sequences=WeightSequencesRespectingOrder{grading.value()};	
 		for (auto H : sequences) {
 			os<<horizontal(H)<<"&"<<horizontal(adapted_basis_from_indices(G.e(),sequences.as_indices(H)));
 			os<<"\\\\"<<endl;			
 			return true;		
 		}	
-		os<<"\\text{weights of split torus: } "<<horizontal(p.grading.value());
+		os<<"\\text{weights of split torus: } "<<horizontal(grading.value());
 	}
 	else os<<"\\text{ERROR: split torus acts nondiagonally}";
 	os<<"\\\\"<<endl;			
 	return false;
 }
 
-bool find_any_ricciflat_metric(const LieGroup& G, const FindMetricParameters& p,ostream& os) {	
-	stringstream foad_stream, filtered_stream, sigma_stream;
-	if (find_foad_metric(G,p,foad_stream)) {
-		os<<"(G1)--(G5):"<<foad_stream.str();			
-		return true;
-	}
-	else if (find_filtered_metric(G,p,filtered_stream)) {
-			os<<"(F1)--(F5):"<<filtered_stream.str();
+//run find_metric in a separate process within the budget if the budget is limited; return nullopt if the budget is exceeded
+template<typename FindFunction>
+optional<bool> find_within_budget(FindFunction& find_metric, const LieGroup& G, const FindMetricParameters& p, ostream& os, Budget budget) {
+	if (budget.unlimited()) return find_metric(G,p,os);
+	auto result=run_within_budget([&find_metric,&G,&p] (ostream& s) {return find_metric(G,p,s);},budget,os);
+	if (!result) return nullopt;
+	os<<result->second;
+	return result->first;
+}
+
+struct FindAnyRicciFlatMetric {
+	Budget engine_budget;	//budget for each attempt; an attempt that exceeds it counts as a failure
+	bool operator()(const LieGroup& G, const FindMetricParameters& p,ostream& os) const {	
+		stringstream foad_stream, filtered_stream, sigma_stream;
+		bool out_of_budget=false;
+		//compute the torus in this process rather than in the process running find_foad_metric, so that it does not count against the budget
+		p.grading();
+		auto attempt=[this,&G,&p,&out_of_budget] (auto& find_metric, ostream& s) {
+			auto found=find_within_budget(find_metric,G,p,s,engine_budget);
+			if (!found) out_of_budget=true;
+			return found.value_or(false);
+		};
+		if (attempt(find_foad_metric,foad_stream)) {
+			os<<"(G1)--(G5):"<<foad_stream.str();			
 			return true;
+		}
+		else if (attempt(find_filtered_metric,filtered_stream)) {
+				os<<"(F1)--(F5):"<<filtered_stream.str();
+				return true;
+		}
+		else if (attempt(find_sigmadiagonal_metric,sigma_stream)) {
+			os<<"&"<<sigma_stream.str();
+			return true;
+		}
+		else {
+			os<<"no Ricci-flat metric found!";
+			if (out_of_budget) os<<" (TIMEOUT)";
+			os<<"\\\\"<<endl;
+			return false;
+		}
 	}
-	else if (find_sigmadiagonal_metric(G,p,sigma_stream)) {
-		os<<"&"<<sigma_stream.str();
-		return true;
-	}
-	else {
-		os<<"no Ricci-flat metric found!\\\\"<<endl;
-		return false;
-	}
-}
+};
 
 string canonical_print_no_brackets(const LieGroup& G) {
 	stringstream s;
@@ -161,17 +265,26 @@ string canonical_print_no_brackets(const LieGroup& G) {
 	return as_string.substr(1,as_string.size()-2);
 }
 
+void print_lie_algebra(const LieGroup& G,ostream& os, int columns_for_lie_algebra) {
+	if (columns_for_lie_algebra>1)		os<<"\\multicolumn{"<<columns_for_lie_algebra<<"}{L}{";
+	os<<canonical_print_no_brackets(G);		
+	if (columns_for_lie_algebra>1) os<<"}"<<"\\\\ ";		
+	os<<"&";
+}
+
 template<typename FindFunction, typename Filter>
 void print_table_row(const LieGroup& G,ostream& os, FindFunction& find_metric,int columns_for_lie_algebra, Filter filter) {	
-	TorusInDer a{G};	
+	StructureConstants structure_constants{G};
+	TorusInDer a{G,structure_constants};	
 	if (filter(a))	{
-		if (columns_for_lie_algebra>1)		os<<"\\multicolumn{"<<columns_for_lie_algebra<<"}{L}{";
-		os<<canonical_print_no_brackets(G);		
-		if (columns_for_lie_algebra>1) os<<"}"<<"\\\\ ";		
-		os<<"&";
-		if (!a.is_a_direct_sum()) os<<"WARNING: torus is not a direct sum of symmetric and skew-symmetric matrices; ";
+		print_lie_algebra(G,os,columns_for_lie_algebra);
+		stringstream s;
+		s.copyfmt(os);
+		find_metric(G,a,s);
+		//the torus is only computed if find_metric uses it
+		if (a.computed() && !a.is_a_direct_sum()) os<<"WARNING: torus is not a direct sum of symmetric and skew-symmetric matrices; ";
 		//a.print_table_row(os);			
-		find_metric(G,a,os);		
+		os<<s.str();
 	}
 }
 template<typename FindFunction>
@@ -188,21 +301,35 @@ void choose_basis_if_one_dimensional(ExVector& v) {
 			x=x.subs(symbols.front()==1);
 }
 
+string canonical_print(const LieGroup& G) {
+	stringstream s;
+	G.canonical_print(s);
+	return s.str();
+}
+
+//the weights of the diagonal torus of a nice Lie group with structure constants c, read from the cache if present
+ExVector diagonal_derivations_on_nice_lie_algebra(const LieGroup& G, const StructureConstants& c, const ResultCache* cache) {
+	if (!cache) return diagonal_derivations_on_nice_lie_algebra(c);
+	auto key=canonical_print(G);
+	auto parameters=diagonal_derivation_parameters(G.Dimension());
+	if (auto cached=cache->get("diagonal-derivations",key)) return linear_forms_from_string(*cached,parameters);
+	auto der=diagonal_derivations_on_nice_lie_algebra(c,parameters);
+	if (auto as_string=linear_forms_to_string(der,parameters)) cache->put("diagonal-derivations",key,*as_string);
+	return der;
+}
+
 template<typename FindFunction, typename Filter>
-void print_table_row_nice(const LieGroup& G,ostream& os, FindFunction& find_metric, int columns_for_lie_algebra,Filter filter) {	
-	GL gl(G.Dimension());	
-	if (columns_for_lie_algebra>1)		os<<"\\multicolumn{"<<columns_for_lie_algebra<<"}{L}{";
-	os<<canonical_print_no_brackets(G);		
-	if (columns_for_lie_algebra>1) os<<"}"<<"\\\\ ";		
-	os<<"&";
-	auto der=diagonal_derivations_on_nice_lie_algebra(G);
+void print_table_row_nice(const LieGroup& G,ostream& os, const ResultCache* cache, FindFunction& find_metric, int columns_for_lie_algebra,Filter filter) {	
+	print_lie_algebra(G,os,columns_for_lie_algebra);
+	StructureConstants structure_constants{G};
+	auto der=diagonal_derivations_on_nice_lie_algebra(G,structure_constants,cache);
 	choose_basis_if_one_dimensional(der);
-	find_metric(G,der,os);	
+	find_metric(G,FindMetricParameters{structure_constants,der},os);	
 }
 template<typename FindFunction>
-void print_table_row_nice(const LieGroup& G,ostream& os, FindFunction& find_metric,int columns_for_lie_algebra) {	
+void print_table_row_nice(const LieGroup& G,ostream& os, const ResultCache* cache, FindFunction& find_metric,int columns_for_lie_algebra) {	
 	auto no_filter=[](auto& ) {return true;};
-	print_table_row_nice(G,os,find_metric, columns_for_lie_algebra, no_filter);	
+	print_table_row_nice(G,os,cache,find_metric, columns_for_lie_algebra, no_filter);	
 }
 
 enum class ClassOfLieAlgebras {
@@ -215,6 +342,21 @@ struct Parameters {
 	ratatoskr::GlobalSymbols symbols;
 	ClassOfLieAlgebras class_of_lie_algebras=ClassOfLieAlgebras::ALL;
 	int columns_for_lie_algebra=1;
+	int jobs=1;
+	string work_dir;
+	int lease_seconds=3600;
+	string journal;
+	string resume;
+	int timeout=0;
+	long memory=0;
+	int retry_timeout=0;
+	long retry_memory=0;
+	int engine_timeout=0;
+	string cache;
+	string mode;	//name of the program being run, part of the key of cached rows
+	FeasibilityAlgorithm feasibility_algorithm=FeasibilityAlgorithm::SIMPLEX;
+	int lp_redundancy=0;
+	RicciAlgorithm ricci_algorithm=RicciAlgorithm::STRUCTURE_CONSTANTS;
 };
 
 auto parameter_description= ratatoskr::make_parameter_description(
@@ -231,27 +373,131 @@ auto parameter_description= ratatoskr::make_parameter_description(
 					
 			"all", "all Lie algebras",ratatoskr::generic_option(&Parameters::class_of_lie_algebras, [] () {return ClassOfLieAlgebras::ALL;})
 		),
-		"columns","columns to use to represent the Lie algebra in the output when printing a table",&Parameters::columns_for_lie_algebra
+		ratatoskr::alternative("simplex|fourier-motzkin")(
+			"simplex", "determine whether linear inequalities have a solution with the exact simplex method (default)",ratatoskr::generic_option(&Parameters::feasibility_algorithm, [] () {return FeasibilityAlgorithm::SIMPLEX;})
+		)(
+			"fourier-motzkin", "determine whether linear inequalities have a solution with Fourier-Motzkin elimination",ratatoskr::generic_option(&Parameters::feasibility_algorithm, [] () {return FeasibilityAlgorithm::FOURIER_MOTZKIN;})
+		),
+		ratatoskr::alternative("ricci-from-structure-constants|generic-ricci|cross-check-ricci")(
+			"ricci-from-structure-constants", "compute the Ricci tensor of sigma-diagonal metrics directly from the structure constants (default)",ratatoskr::generic_option(&Parameters::ricci_algorithm, [] () {return RicciAlgorithm::STRUCTURE_CONSTANTS;})
+		)(
+			"generic-ricci", "compute the Ricci tensor of sigma-diagonal metrics through the Levi-Civita connection of a generic metric",ratatoskr::generic_option(&Parameters::ricci_algorithm, [] () {return RicciAlgorithm::GENERIC;})
+		)(
+			"cross-check-ricci", "compute the Ricci tensor of sigma-diagonal metrics both ways, and stop with an error if the results differ",ratatoskr::generic_option(&Parameters::ricci_algorithm, [] () {return RicciAlgorithm::CROSS_CHECK;})
+		),
+		"columns","columns to use to represent the Lie algebra in the output when printing a table",&Parameters::columns_for_lie_algebra,
+		"jobs","number of worker processes to use when printing a table, or when looking for sigma-diagonal metrics on a single Lie algebra",&Parameters::jobs,
+		"work-dir","share the computation of the table with other processes through a directory, to be assembled with merge",&Parameters::work_dir,
+		"lease","seconds after which a range of rows claimed in the work directory by a process that stopped responding is reclaimed",&Parameters::lease_seconds,
+		"journal","record each row of the table in a new journal file as soon as it is computed",&Parameters::journal,
+		"resume","resume the computation of a table recorded in a journal file, skipping the rows it contains",&Parameters::resume,
+		"timeout","seconds allowed for each row of a table before it is marked as TIMEOUT",&Parameters::timeout,
+		"memory","megabytes of resident memory allowed for each row of a table before it is marked as TIMEOUT",&Parameters::memory,
+		"retry-timeout","seconds allowed for each row that exceeded its budget, computed again at the end of the table",&Parameters::retry_timeout,
+		"retry-memory","megabytes of resident memory allowed for each row that exceeded its budget, computed again at the end of the table",&Parameters::retry_memory,
+		"engine-timeout","seconds allowed for each attempt at finding a metric in mode any, after which the next method is tried",&Parameters::engine_timeout,
+		"cache","directory of a persistent cache of rows, torus weights and computations with ideals, reused by later runs",&Parameters::cache,
+		"lp-redundancy","remove redundant linear inequalities by linear programming whenever Fourier-Motzkin elimination produces more than this number (0 to disable)",&Parameters::lp_redundancy
+	);
+
+auto merge_parameter_description= ratatoskr::make_parameter_description(
+		"work-dir","directory where the rows of the table have been computed",&Parameters::work_dir
 	);
 
+//record the mode and apply the parameters that affect global settings
+void start_program(Parameters& parameters, const string& mode) {
+	parameters.mode=mode;
+	feasibility_algorithm=parameters.feasibility_algorithm;
+	lp_redundancy_threshold=parameters.lp_redundancy;
+	ricci_algorithm=parameters.ricci_algorithm;
+	if (!parameters.cache.empty()) ideal_cache.use_directory(parameters.cache);
+	//when computing a table, the rows are already distributed among the worker processes
+	if (parameters.G) involution_jobs=parameters.jobs;
+}
+
+SweepParameters sweep_parameters(const Parameters& parameters) {
+	SweepParameters sweep;
+	sweep.jobs=parameters.jobs;
+	sweep.budget=Budget{std::chrono::seconds{parameters.timeout},parameters.memory};
+	if (parameters.retry_timeout || parameters.retry_memory)
+		sweep.retry_budget=Budget{std::chrono::seconds{parameters.retry_timeout},parameters.retry_memory};
+	return sweep;
+}
+
+Budget engine_budget(const Parameters& parameters) {
+	if (!parameters.engine_timeout) return {};
+	return Budget{std::chrono::seconds{parameters.engine_timeout},parameters.memory};
+}
+
+//a string identifying a table and the settings its rows depend on: the dimension, the mode, the class of Lie algebras, the number of columns and the algorithm used
+//to solve linear inequalities, which may find a different solution, as may Fourier-Motzkin elimination with a different redundancy threshold; the Ricci tensor
+//is printed in a form that depends on the algorithm used to compute it
+string table_key(const Parameters& parameters) {
+	return "dimension:"+to_string(parameters.d)+" "+parameters.mode+" "+to_string(static_cast<int>(parameters.class_of_lie_algebras))+" "+to_string(parameters.columns_for_lie_algebra)
+		+" feasibility:"+to_string(static_cast<int>(parameters.feasibility_algorithm))
+		+" lp-redundancy:"+(parameters.lp_redundancy? to_string(parameters.lp_redundancy) : "none")
+		+" ricci:"+to_string(static_cast<int>(parameters.ricci_algorithm));
+}
+
+//the key identifying a row of a table in the cache
+string row_cache_key(const Parameters& parameters, const LieGroup& G) {
+	return table_key(parameters)+" "+canonical_print(G);
+}
+
 template<typename FindFunction>
 void study_one(const LieGroup& G, ostream& os,  FindFunction& f) {
 	print_table_row(G,os,f,1);
 }
 
-template<typename Classification, typename... FindFunctionAndFilter>	
-void study_classification(Parameters& parameters, ostream& os, const Classification& classification, FindFunctionAndFilter... f) {
-	if (parameters.class_of_lie_algebras==ClassOfLieAlgebras::NICE) 
-		for (auto& G: classification)
-			print_table_row_nice(*G,os,f...);	
-	else	
-		for (auto& G: classification)
-			print_table_row(*G,os,f...);		
+//each Lie group is constructed when its row is computed, and destroyed when the row has been printed
+template<typename... FindFunctionAndFilter>	
+void study_classification(Parameters& parameters, ostream& os, const GroupClassification& classification, FindFunctionAndFilter... f) {
+	//create the workspace before the rows are distributed among worker processes, so that it is shared by all rows
+	Workspace::of_dimension(parameters.d);
+	optional<ResultCache> cache;
+	if (!parameters.cache.empty()) cache.emplace(parameters.cache);
+	//rows where an engine exceeded its budget are not cached, since they may succeed with a different budget; when cross-checking the Ricci tensor, rows are
+	//always computed, so that the check is performed
+	bool cache_rows=cache && !parameters.engine_timeout && parameters.ricci_algorithm!=RicciAlgorithm::CROSS_CHECK;
+	auto print_row=[&parameters,&classification,&cache,cache_rows,f...] (int i, ostream& os) mutable {
+		auto group=classification.construct(i);
+		auto& G=*group;
+		string key;
+		if (cache_rows) {
+			key=row_cache_key(parameters,G);
+			if (auto row=cache->get("row",key)) {
+				os<<*row;
+				return;
+			}
+		}
+		stringstream s;
+		s.copyfmt(os);
+		if (parameters.class_of_lie_algebras==ClassOfLieAlgebras::NICE) 
+			print_table_row_nice(G,s,cache? &*cache : nullptr,f...);	
+		else	
+			print_table_row(G,s,f...);		
+		if (cache_rows) cache->put("row",key,s.str());
+		os<<s.str();
+	};
+	auto print_out_of_budget_row=[&parameters,&classification] (int i, ostream& os) {
+		print_lie_algebra(*classification.construct(i),os,parameters.columns_for_lie_algebra);
+		os<<"\\text{TIMEOUT}\\\\"<<endl;
+	};
+	auto sweep=sweep_parameters(parameters);
+	if (!parameters.work_dir.empty())
+		compute_rows_in_work_directory(WorkDirectory{parameters.work_dir,table_key(parameters)},classification.size(),print_row,print_out_of_budget_row,sweep,os,std::chrono::seconds{parameters.lease_seconds});
+	else {
+		unique_ptr<Journal> journal;
+		if (!parameters.resume.empty()) journal=make_unique<Journal>(parameters.resume,table_key(parameters),classification.size(),true);
+		else if (!parameters.journal.empty()) journal=make_unique<Journal>(parameters.journal,table_key(parameters),classification.size(),false);
+		print_rows(classification.size(),print_row,print_out_of_budget_row,os,sweep,journal.get());
+	}
 }
 
 template<typename... FindFunctionAndFilter>
 void study_all(Parameters& parameters, ostream& os, FindFunctionAndFilter... f) {
-		os<<"%\\begin{array}{ccc}"<<endl;		
+		bool print_table=parameters.work_dir.empty();	//otherwise, the table is printed by merge
+		if (print_table) os<<"%\\begin{array}{ccc}"<<endl;		
 		if (parameters.class_of_lie_algebras==ClassOfLieAlgebras::NONNICE) {
 			if (parameters.d!=7) 
 				cerr<<"not implemented"<<endl;
@@ -288,11 +534,12 @@ void study_all(Parameters& parameters, ostream& os, FindFunctionAndFilter... f)
 		default:
 			cerr<<"unsupported dimension "<<parameters.d<<endl;
 		}
-		os<<"%\\end{array}"<<endl;
+		if (print_table) os<<"%\\end{array}"<<endl;
 }
 
 auto program1=ratatoskr::make_program_description(
 	"sigma-diagonal", "study sigma-diagonal metrics", parameter_description, [] (Parameters& parameters, ostream& os) {
+		start_program(parameters,"sigma-diagonal");
 		if (parameters.G)
 			study_one(*parameters.G,os,find_sigmadiagonal_metric);
 		else			
@@ -304,6 +551,7 @@ auto program1=ratatoskr::make_program_description(
 
 auto program2=ratatoskr::make_program_description(
 	"graded", "study gradings satisfying (G1)--(G5)", parameter_description, [] (Parameters& parameters, ostream& os) {
+		start_program(parameters,"graded");
 		if (parameters.G)
 			study_one(*parameters.G,os,find_foad_metric);
 		else			
@@ -313,6 +561,7 @@ auto program2=ratatoskr::make_program_description(
 
 auto program3=ratatoskr::make_program_description(
 	"filtered", "study filtrations satisfying (F1)--(F5)", parameter_description, [] (Parameters& parameters, ostream& os) {
+		start_program(parameters,"filtered");
 		if (parameters.G)
 			study_one(*parameters.G,os,find_filtered_metric);
 		else			
@@ -322,6 +571,8 @@ auto program3=ratatoskr::make_program_description(
 
 auto program4=ratatoskr::make_program_description(
 	"any", "find a Ricci-flat metric of any type", parameter_description, [] (Parameters& parameters, ostream& os) {
+		start_program(parameters,"any");
+		FindAnyRicciFlatMetric find_any_ricciflat_metric{engine_budget(parameters)};
 		if (parameters.G)
 			study_one(*parameters.G,os,find_any_ricciflat_metric);
 		else			
@@ -330,7 +581,8 @@ auto program4=ratatoskr::make_program_description(
 );	
 
 void print_derivations(const LieGroup& G, ostream& os) {
-	TorusInDer torus{G};
+	StructureConstants structure_constants{G};
+	TorusInDer torus{G,structure_constants};
 	torus.print(os);
 	os<<endl;	
 	Grading grading{torus.linear_group(),torus.grading().value(),torus.nilradical()};
@@ -344,7 +596,13 @@ auto program5=ratatoskr::make_program_description(
 );
 
 
+auto program6=ratatoskr::make_program_description(
+	"merge", "print the table computed by one or more processes with --work-dir", merge_parameter_description, [] (Parameters& parameters, ostream& os) {
+		merge_work_directory(WorkDirectory{parameters.work_dir},os);
+	}
+);
+
 int main(int argv, char** argc) {				
-	ratatoskr::alternative_program_descriptions(program1,program2,program3,program4,program5).run(argv,argc);
+	ratatoskr::alternative_program_descriptions(program1,program2,program3,program4,program5,program6).run(argv,argc);
 }
 
@@ -0,0 +1,65 @@
+#ifndef STRUCTURECONSTANTS_H
+#define STRUCTURECONSTANTS_H
+
+#include <cstdint>
+
+/** The structure constants of a Lie algebra relative to the basis G.e(), computed once and stored in a form suitable for lookups in combinatorial loops.
+
+The constant c_ij^k, with i<j, is the coefficient of e^{ij} in de^k. Nonzero constants are stored sparsely, grouped by k; in addition, bitmasks record
+for each pair (i,j) the indices k such that c_ij^k is nonzero, and for each k and i the indices j such that c_ij^k or c_ji^k is nonzero, so that the
+pattern of nonzero constants can be queried without computing with forms. Indices are zero-based, and the dimension can be at most 64.
+*/
+class StructureConstants {
+public:
+	using Mask = uint64_t;
+	struct Entry {
+		int i,j;	//i<j
+		ex c;
+	};
+private:
+	int n;
+	vector<int> first_entry;	//the constants appearing in de^k are entries[first_entry[k]],...,entries[first_entry[k+1]-1]
+	vector<Entry> entries;
+	vector<Mask> components_;	//components_[i*n+j] is the set of k such that c_ij^k is nonzero
+	vector<Mask> adjacent;		//adjacent[k*n+i] is the set of j such that c_ij^k or c_ji^k is nonzero
+public:
+	static Mask bit(int i) {return Mask{1}<<i;}
+	//the set of indices greater than i
+	static Mask above(int i) {return i>=63? 0 : ~Mask{0}<<(i+1);}
+
+	StructureConstants(const LieGroup& G) : n{G.Dimension()}, components_(n*n), adjacent(n*n) {
+		if (n>64) throw invalid_argument("StructureConstants: dimension greater than 64");
+		first_entry.push_back(0);
+		for (int k=0;k<n;++k) {
+			ex de_k=G.d(G.e()[k]);
+			for (int i=0;i<n && !de_k.is_zero();++i) {
+				ex e_i_hook_de_k=Hook(G.e()[i],de_k);
+				if (e_i_hook_de_k.is_zero()) continue;
+				for (int j=i+1;j<n;++j) {
+					ex c=TrivialPairing<DifferentialForm>(G.e()[j],e_i_hook_de_k).expand();
+					if (c.is_zero()) continue;
+					entries.push_back(Entry{i,j,c});
+					components_[i*n+j]|=bit(k);
+					components_[j*n+i]|=bit(k);
+					adjacent[k*n+i]|=bit(j);
+					adjacent[k*n+j]|=bit(i);
+				}
+			}
+			first_entry.push_back(entries.size());
+		}
+	}
+	int dimension() const {return n;}
+	//the set of k such that [e_a,e_b] has a nonzero component along e_k
+	Mask components(int a, int b) const {return components_[a*n+b];}
+	//true if e_a\wedge e_b\hook de^c is nonzero
+	bool bracket_nonzero(int a, int b, int c) const {return components(a,b) & bit(c);}
+	//true if e_i\hook de^k is nonzero
+	bool hook_nonzero(int i, int k) const {return adjacent[k*n+i];}
+	//the set of j such that e_i\wedge e_j\hook de^k is nonzero
+	Mask adjacent_to(int i, int k) const {return adjacent[k*n+i];}
+	//the nonzero constants c_ij^k for fixed k
+	const Entry* begin(int k) const {return entries.data()+first_entry[k];}
+	const Entry* end(int k) const {return entries.data()+first_entry[k+1];}
+};
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include "fdio.h"
+#include "journal.h"
+
+//limits on the resources used by a worker process; zero means no limit
+struct Budget {
+	std::chrono::seconds time{0};
+	long memory_mb=0;
+	bool unlimited() const {return !time.count() && !memory_mb;}
+};
+
+struct WorkerResult {
+	int task;
+	string output;
+	bool out_of_budget=false;	//if true, the worker was killed before completing the task, and output is empty
+};
+
+/** A pool of forked processes, each computing a function of an integer task index and returning a string.
+
+GiNaC and CoCoA are not thread-safe, so parallelism is obtained through processes. Workers are forked when a task is submitted and no
+worker is idle, and inherit the memory of the parent at that time; tasks are handed out one at a time, so that idle workers pick up the 
+next task as soon as they are done. A worker that exceeds its budget on a task is killed, and replaced by a new one when needed.
+*/
+class WorkerPool {
+	struct Worker {
+		pid_t pid=0;
+		int to_worker=-1;	//pipe on which task indices are sent
+		int from_worker=-1;	//pipe on which results are received
+		int task=-1;		//task being computed, or -1 if the worker is idle
+		std::chrono::steady_clock::time_point started;
+	};
+	vector<Worker> workers;
+	int size;
+	function<string(int)> task;
+	Budget budget;
+
+	static long resident_memory_mb(pid_t pid) {
+		std::ifstream statm{"/proc/"+to_string(pid)+"/statm"};
+		long size=0, resident=0;
+		statm>>size>>resident;
+		return resident*sysconf(_SC_PAGESIZE)/(1024*1024);
+	}
+	bool exceeds_budget(const Worker& worker) const {
+		if (budget.time.count() && std::chrono::steady_clock::now()-worker.started>budget.time) return true;
+		return budget.memory_mb && resident_memory_mb(worker.pid)>budget.memory_mb;
+	}
+	WorkerResult terminate(vector<Worker>::iterator worker) {
+		WorkerResult result{worker->task,{},true};
+		kill(worker->pid,SIGKILL);
+		close(worker->to_worker);
+		close(worker->from_worker);
+		waitpid(worker->pid,nullptr,0);
+		workers.erase(worker);
+		return result;
+	}
+
+	[[noreturn]] void run_worker(int from_parent, int to_parent) {
+		using namespace fdio;
+		try {
+			int index;
+			while (read_fully(from_parent,&index,sizeof(index))) {
+				auto result=task(index);
+				uint64_t size=result.size();
+				write_fully(to_parent,&index,sizeof(index));
+				write_fully(to_parent,&size,sizeof(size));
+				write_fully(to_parent,result.data(),size);
+			}
+		}
+		catch (const std::exception& e) {
+			cerr<<"worker process "<<getpid()<<": "<<e.what()<<endl;
+			_exit(EXIT_FAILURE);
+		}
+		catch (...) {	//e.g. CoCoA::ErrorInfo, which is not a std::exception; it must not unwind into the copy of the parent's stack
+			cerr<<"worker process "<<getpid()<<": unknown exception"<<endl;
+			_exit(EXIT_FAILURE);
+		}
+		_exit(EXIT_SUCCESS);	//do not run the parent's exit handlers, nor flush its buffers
+	}
+	Worker& spawn() {
+		assert(workers.size()<size);
+		int to_worker[2], from_worker[2];
+		if (pipe(to_worker) || pipe(from_worker)) throw std::runtime_error(string("cannot create pipe: ")+strerror(errno));
+		cout.flush();
+		cerr.flush();
+		auto pid=fork();
+		if (pid<0) throw std::runtime_error(string("cannot fork worker process: ")+strerror(errno));
+		if (pid==0) {
+			prctl(PR_SET_PDEATHSIG,SIGKILL);	//workers of a worker killed for exceeding its budget should not survive it
+			for (auto& other : workers) {
+				close(other.to_worker);
+				close(other.from_worker);
+			}
+			close(to_worker[1]);
+			close(from_worker[0]);
+			run_worker(to_worker[0],from_worker[1]);
+		}
+		close(to_worker[0]);
+		close(from_worker[1]);
+		workers.push_back(Worker{pid,to_worker[1],from_worker[0],-1,{}});
+		return workers.back();
+	}
+	WorkerResult receive(Worker& worker) {
+		using namespace fdio;
+		WorkerResult result;
+		uint64_t size;
+		if (!read_fully(worker.from_worker,&result.task,sizeof(result.task)) || !read_fully(worker.from_worker,&size,sizeof(size)))
+			throw std::runtime_error("worker process "+to_string(worker.pid)+" terminated while computing task "+to_string(worker.task));
+		result.output.resize(size);
+		if (!read_fully(worker.from_worker,&result.output[0],size))
+			throw std::runtime_error("worker process "+to_string(worker.pid)+" terminated while computing task "+to_string(worker.task));
+		worker.task=-1;
+		return result;
+	}
+public:
+	WorkerPool(int size, function<string(int)> task, Budget budget={}) : size{size}, task{move(task)}, budget{budget} {
+		signal(SIGPIPE,SIG_IGN);	//a dead worker is reported as an error when reading its result
+		workers.reserve(size);
+	}
+	WorkerPool(const WorkerPool&)=delete;
+	WorkerPool& operator=(const WorkerPool&)=delete;
+	~WorkerPool() {
+		for (auto& worker : workers) {
+			if (worker.task>=0) kill(worker.pid,SIGKILL);
+			close(worker.to_worker);
+			close(worker.from_worker);
+		}
+		for (auto& worker : workers) waitpid(worker.pid,nullptr,0);
+	}
+	bool has_idle_worker() const {
+		return workers.size()<size || any_of(workers.begin(),workers.end(),[] (auto& worker) {return worker.task<0;});
+	}
+	bool busy() const {
+		return any_of(workers.begin(),workers.end(),[] (auto& worker) {return worker.task>=0;});
+	}
+	//assign a task to an idle worker, forking a new one if needed; assumes has_idle_worker()
+	void submit(int task) {
+		auto worker=find_if(workers.begin(),workers.end(),[] (auto& worker) {return worker.task<0;});
+		auto& idle = worker!=workers.end()? *worker : spawn();
+		fdio::write_fully(idle.to_worker,&task,sizeof(task));
+		idle.task=task;
+		idle.started=std::chrono::steady_clock::now();
+	}
+	//kill the worker computing the given task, if any; its result is never returned
+	void cancel(int task) {
+		auto worker=find_if(workers.begin(),workers.end(),[task] (auto& worker) {return worker.task==task;});
+		if (worker!=workers.end()) terminate(worker);
+	}
+	//wait until one of the busy workers returns a result or exceeds its budget; assumes busy()
+	WorkerResult next_result() {
+		assert(busy());
+		while (true) {
+			vector<pollfd> fds;
+			vector<Worker*> polled;
+			for (auto& worker : workers)
+				if (worker.task>=0) {
+					fds.push_back(pollfd{worker.from_worker,POLLIN,0});
+					polled.push_back(&worker);
+				}
+			if (poll(fds.data(),fds.size(),budget.unlimited()? -1 : 1000)<0) {
+				if (errno==EINTR) continue;
+				throw std::runtime_error(string("poll failed: ")+strerror(errno));
+			}
+			for (int i=0;i<fds.size();++i)
+				if (fds[i].revents) return receive(*polled[i]);
+			for (auto worker=workers.begin();worker!=workers.end();++worker)
+				if (worker->task>=0 && exceeds_budget(*worker)) return terminate(worker);
+		}
+	}
+};
+
+//run a function in a separate process, returning its result and output, or nullopt if the process exceeds the budget
+optional<pair<bool,string>> run_within_budget(const function<bool(ostream&)>& f, Budget budget, const ostream& format) {
+	WorkerPool pool{1,[&f,&format] (int) {
+		stringstream s;
+		s.copyfmt(format);
+		bool result=f(s);
+		return (result? "1" : "0")+s.str();
+	},budget};
+	pool.submit(0);
+	auto result=pool.next_result();
+	if (result.out_of_budget) return nullopt;
+	return make_pair(result.output.front()=='1',result.output.substr(1));
+}
+
+//how the rows of a table are distributed among processes
+struct SweepParameters {
+	int jobs=1;		//number of worker processes
+	Budget budget;		//budget for each row
+	optional<Budget> retry_budget;	//if set, rows that exceed the budget are computed again with this budget after all other rows
+};
+
+/** Compute rows of a table
+
+@param next_row A function returning the index of the next row to compute, or nullopt if there is no row to hand out at the moment
+@param print_row A function printing the i-th row on a stream
+@param row_done A function called with the index of each row, a flag indicating whether it has exceeded the budget and its output, as soon as it has been computed, not necessarily in order
+@param jobs The number of worker processes; if jobs<=1 and the budget is unlimited, rows are computed in the current process
+@param format A stream whose formatting flags are used to print the rows
+@param budget The budget for each row
+*/
+void compute_rows(const function<optional<int>()>& next_row, const function<void(int,ostream&)>& print_row, const function<void(int,bool,string&&)>& row_done, int jobs, const ostream& format, Budget budget={}) {
+	auto row_to_string=[&print_row,&format] (int i) {
+		stringstream s;
+		s.copyfmt(format);
+		print_row(i,s);
+		return s.str();
+	};
+	if (jobs<=1 && budget.unlimited()) {
+		while (auto i=next_row()) row_done(*i,false,row_to_string(*i));
+		return;
+	}
+	WorkerPool pool{max(jobs,1),row_to_string,budget};
+	optional<int> row;
+	while (true) {
+		while (pool.has_idle_worker() && (row=next_row())) pool.submit(*row);
+		if (!pool.busy()) break;
+		auto result=pool.next_result();
+		if (result.out_of_budget) cerr<<"row "<<result.task+1<<" exceeded its budget"<<endl;
+		row_done(result.task,result.out_of_budget,move(result.output));
+	}
+}
+
+/** Print the rows of a table in their original order
+
+@param rows The number of rows
+@param print_row A function printing the i-th row on a stream
+@param print_out_of_budget_row A function printing the i-th row on a stream when its computation exceeds the budget
+@param os The stream on which the table is printed
+@param sweep Parameters determining the number of worker processes and the budgets; rows are computed as soon as a worker is available, and reassembled in order by the parent process
+@param journal If not null, a journal where each row is recorded as soon as it is computed; rows already recorded in the journal are not computed again, unless they exceeded the budget and a retry budget is set
+*/
+void print_rows(int rows, const function<void(int,ostream&)>& print_row, const function<void(int,ostream&)>& print_out_of_budget_row, ostream& os, const SweepParameters& sweep, Journal* journal=nullptr) {
+	static const string COMPUTED="ok", OUT_OF_BUDGET="timeout";
+	os.flush();
+	map<int,string> completed;
+	set<int> deferred;
+	int next_row=0, next_to_print=0;
+	auto print_completed_rows=[&completed,&next_to_print,&os] () {
+		for (auto row=completed.begin(); row!=completed.end() && row->first==next_to_print; row=completed.erase(row), ++next_to_print)
+			os<<row->second;
+		os.flush();
+	};
+	auto out_of_budget_row=[&print_out_of_budget_row,&os] (int i) {
+		stringstream s;
+		s.copyfmt(os);
+		print_out_of_budget_row(i,s);
+		return s.str();
+	};
+	if (journal) {
+		for (auto& row : journal->recorded()) 
+			if (row.second.status==OUT_OF_BUDGET && sweep.retry_budget) deferred.insert(row.first);
+			else completed[row.first]=row.second.output;
+		print_completed_rows();
+	}
+	auto hand_out_row=[&next_row,&next_to_print,&completed,&deferred,rows] () -> optional<int> {
+		while (next_row<rows && (next_row<next_to_print || completed.count(next_row) || deferred.count(next_row))) ++next_row;
+		if (next_row<rows) return next_row++;
+		return nullopt;
+	};
+	auto row_done=[&] (int i, bool out_of_budget, string&& output) {
+		if (out_of_budget) output=out_of_budget_row(i);
+		if (journal) journal->record(i,out_of_budget? OUT_OF_BUDGET : COMPUTED,output);
+		if (out_of_budget && sweep.retry_budget) deferred.insert(i);
+		else {
+			completed[i]=move(output);
+			print_completed_rows();
+		}
+	};
+	compute_rows(hand_out_row,print_row,row_done,sweep.jobs,os,sweep.budget);
+	if (deferred.empty()) return;
+	cerr<<"computing "<<deferred.size()<<" deferred rows with a larger budget"<<endl;
+	auto next_deferred=deferred.begin();
+	auto hand_out_deferred_row=[&next_deferred,&deferred] () -> optional<int> {
+		if (next_deferred==deferred.end()) return nullopt;
+		return *next_deferred++;
+	};
+	auto deferred_row_done=[&] (int i, bool out_of_budget, string&& output) {
+		if (out_of_budget) output=out_of_budget_row(i);
+		if (journal) journal->record(i,out_of_budget? OUT_OF_BUDGET : COMPUTED,output);
+		completed[i]=move(output);
+		print_completed_rows();
+	};
+	compute_rows(hand_out_deferred_row,print_row,deferred_row_done,sweep.jobs,os,sweep.retry_budget.value());
+}
+
+#endif
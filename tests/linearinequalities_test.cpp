@@ -0,0 +1,32 @@
+//tests for the solutions of systems of linear inequalities and equations in linearinequalities.h
+#include <wedge/wedge.h>
+#include <iostream>
+using namespace GiNaC;
+using namespace std;
+using namespace Wedge;
+#include "../linearinequalities.h"
+
+void check(bool condition, const string& what) {
+	if (condition) return;
+	cerr<<"check failed: "<<what<<endl;
+	exit(EXIT_FAILURE);
+}
+
+//a weight fixed by an equality must take the value determined by the other weights, not the value assigned to free unknowns
+void test_weight_fixed_by_equality(FeasibilityAlgorithm algorithm) {
+	feasibility_algorithm=algorithm;
+	symbol w1("w1"),w2("w2"),w3("w3");
+	auto l=LinearInequalities<symbol>{}.positive(list<ex>{w1-1,w2-1}).zero(list<ex>{w3-w1-w2});
+	auto solution=l.find_solution();
+	check(solution.nops()!=0,"the system has a solution");
+	ex v1=w1.subs(solution), v2=w2.subs(solution), v3=w3.subs(solution);
+	check(is_a<numeric>(v1) && is_a<numeric>(v2) && is_a<numeric>(v3),"every weight is assigned a number");
+	check(v1>1 && v2>1,"the inequalities are satisfied");
+	check((v3-v1-v2).is_zero(),"the weight fixed by the equality has the correct value");
+}
+
+int main() {
+	test_weight_fixed_by_equality(FeasibilityAlgorithm::FOURIER_MOTZKIN);
+	test_weight_fixed_by_equality(FeasibilityAlgorithm::SIMPLEX);
+	cout<<"linear inequalities tests passed"<<endl;
+}
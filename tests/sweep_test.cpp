@@ -0,0 +1,70 @@
+//tests for the pool of worker processes in sweep.h, which does not depend on Wedge
+#include <cassert>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+#include "../sweep.h"
+
+struct NotAStdException {};
+
+void check(bool condition, const string& what) {
+	if (condition) return;
+	cerr<<"check failed: "<<what<<endl;
+	exit(EXIT_FAILURE);
+}
+
+//a task throwing an exception which does not derive from std::exception must terminate the worker, not resume the parent's code in the child
+void test_worker_throwing_non_std_exception() {
+	pid_t parent=getpid();
+	int escaped[2];
+	if (pipe(escaped)) {
+		cerr<<"cannot create pipe: "<<strerror(errno)<<endl;
+		exit(EXIT_FAILURE);
+	}
+	bool caught=false;
+	try {
+		WorkerPool pool{2,[] (int task) -> string {
+			if (task==1) throw NotAStdException{};
+			return to_string(task);
+		}};
+		pool.submit(1);
+		pool.next_result();
+	}
+	catch (const std::runtime_error&) {
+		caught=true;
+	}
+	catch (const NotAStdException&) {}	//only reached if the exception escaped into the worker, which is detected below
+	if (getpid()!=parent) {		//the exception escaped into the worker, which is now running the parent's code
+		char c='x';
+		fdio::write_fully(escaped[1],&c,1);
+		_exit(EXIT_FAILURE);
+	}
+	close(escaped[1]);
+	char c;
+	bool worker_escaped=fdio::read_fully(escaped[0],&c,1);
+	close(escaped[0]);
+	check(!worker_escaped,"the worker does not run the code of the parent");
+	check(caught,"the parent reports the termination of the worker");
+}
+
+void test_results_are_returned() {
+	WorkerPool pool{3,[] (int task) {return to_string(task*task);}};
+	vector<string> results(5);
+	int next=0;
+	while (true) {
+		while (pool.has_idle_worker() && next<5) pool.submit(next++);
+		if (!pool.busy()) break;
+		auto result=pool.next_result();
+		results[result.task]=result.output;
+	}
+	check(results==vector<string>{"0","1","4","9","16"},"the results of all tasks are returned");
+}
+
+int main() {
+	test_results_are_returned();
+	test_worker_throwing_non_std_exception();
+	cout<<"sweep tests passed"<<endl;
+}
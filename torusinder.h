@@ -1,14 +1,45 @@
 #include "sumintersect.h"
 
+/** A grading of R^n with weights w_1,...,w_n, inducing a decomposition of gl(n) into weight spaces, where the matrix whose only nonzero entry is in position
+(i,j) has weight w_i-w_j. The trace form pairs the weight spaces of weights alpha and -alpha, and is zero on any other pair of weight spaces.
+*/
+class WeightSpaces {
+	exvector weights;
+public:
+	WeightSpaces(const exvector& weights) : weights{weights} {}
+	//the weight of an element of gl, or nullopt if it is not contained in a weight space
+	optional<ex> weight(const GL& gl, ex gl_element) const {
+		matrix m=gl.glToMatrix(gl_element);
+		optional<ex> result;
+		for (int i=0;i<m.rows();++i)
+		for (int j=0;j<m.cols();++j) {
+			if (m(i,j).is_zero()) continue;
+			ex w=(weights[i]-weights[j]).expand();
+			if (!result) result=w;
+			else if (!(w-result.value()).expand().is_zero()) return nullopt;
+		}
+		return result? result : ex{0};
+	}
+	//the elements of a basis grouped by weight, or nullopt if some element is not contained in a weight space
+	optional<map<ex,exvector,ex_is_less>> by_weight(const GL& gl, const exvector& basis) const {
+		map<ex,exvector,ex_is_less> result;
+		for (auto& x: basis)
+			if (auto w=weight(gl,x)) result[w.value()].push_back(x);
+			else return nullopt;
+		return result;
+	}
+};
+
 class TraceScalarProduct {
+	const Workspace& workspace;
 	const GL& gl;
 public:
-	TraceScalarProduct(const  GL& gl) : gl{gl} {}
+	TraceScalarProduct(const Workspace& workspace) : workspace{workspace}, gl{workspace.gl()} {}
 	ex tr(ex gl_element) const {
 		return ex_to<matrix>(gl.glToMatrix(gl_element)).trace();
 	}
 	ex tr_product(ex gl_element1, ex gl_element2) const {
-		return ex_to<matrix>((gl.glToMatrix(gl_element1)*gl.glToMatrix(gl_element2)).evalm()).trace();
+		return workspace.tr_product(gl_element1,gl_element2);
 	}
 	VectorSpace<DifferentialForm> perp(const VSpace<DifferentialForm>& subspace, const VSpace<DifferentialForm>& space) const {
 		auto gen_elem=space.GenericElement();
@@ -17,11 +48,30 @@ public:
 			GetCoefficients<DifferentialForm>(eqns,tr_product(x,gen_elem));
 		return space.SubspaceFromEquations(eqns.begin(),eqns.end());
 	}
+	//the same as perp(subspace,space), computed separately on each weight space if both subspace and space have a basis of weight vectors
+	VectorSpace<DifferentialForm> perp(const VSpace<DifferentialForm>& subspace, const VSpace<DifferentialForm>& space, const WeightSpaces& weight_spaces) const {
+		auto subspace_by_weight=weight_spaces.by_weight(gl,subspace.e());
+		auto space_by_weight=weight_spaces.by_weight(gl,space.e());
+		if (!subspace_by_weight || !space_by_weight) return perp(subspace,space);
+		exvector result;
+		for (auto& weight_and_basis: space_by_weight.value()) {
+			auto& space_alpha=weight_and_basis.second;
+			auto subspace_minus_alpha=subspace_by_weight->find((-weight_and_basis.first).expand());
+			if (subspace_minus_alpha==subspace_by_weight->end())
+				result.insert(result.end(),space_alpha.begin(),space_alpha.end());
+			else {
+				auto& generators=subspace_minus_alpha->second;
+				auto perp_alpha=perp(VectorSpace<DifferentialForm>{generators.begin(),generators.end()},VectorSpace<DifferentialForm>{space_alpha.begin(),space_alpha.end()});
+				result.insert(result.end(),perp_alpha.e().begin(),perp_alpha.e().end());
+			}
+		}
+		return VectorSpace<DifferentialForm>{result.begin(),result.end()};
+	}
 };
 
-VectorSpace<DifferentialForm> nilpotent_derivations(const LieGroup& G, const GL& gl) {
-	auto all_der=derivations(G,gl);	
-	TraceScalarProduct t{gl};
+VectorSpace<DifferentialForm> nilpotent_derivations(const LieGroup& G, const Workspace& workspace) {
+	auto all_der=derivations(G,workspace.gl());	
+	TraceScalarProduct t{workspace};
 	auto nil_der=t.perp(all_der,all_der);
 	return nil_der;
 }
@@ -36,14 +86,14 @@ VectorSpace<DifferentialForm> derived_subalgebra(const VectorSpace<DifferentialF
 }
 
 
-VectorSpace<DifferentialForm> nilradical_of_linear_algebra(const VectorSpace<DifferentialForm>& linear_algebra, const GL& gl) {	
-	auto nilradical=TraceScalarProduct{gl}.perp(linear_algebra,linear_algebra);
+VectorSpace<DifferentialForm> nilradical_of_linear_algebra(const VectorSpace<DifferentialForm>& linear_algebra, const Workspace& workspace, const WeightSpaces& weight_spaces) {	
+	auto nilradical=TraceScalarProduct{workspace}.perp(linear_algebra,linear_algebra,weight_spaces);
     return nilradical;
 }
 
-VectorSpace<DifferentialForm> radical_of_linear_algebra(const VectorSpace<DifferentialForm>& linear_algebra, const GL& gl) {
-	auto derived_algebra=derived_subalgebra(linear_algebra,gl);
-	auto radical=TraceScalarProduct{gl}.perp(derived_algebra,linear_algebra);
+VectorSpace<DifferentialForm> radical_of_linear_algebra(const VectorSpace<DifferentialForm>& linear_algebra, const Workspace& workspace, const WeightSpaces& weight_spaces) {
+	auto derived_algebra=derived_subalgebra(linear_algebra,workspace.gl());
+	auto radical=TraceScalarProduct{workspace}.perp(derived_algebra,linear_algebra,weight_spaces);
     return radical;
 }
 
@@ -60,42 +110,67 @@ optional<exvector> diagonal_elements_if_diagonal_matrix(const matrix& m) {
 }
 
 class SymmetricAndSkewDecomposition {
-    const GL& gl;
-    VectorSpace<DifferentialForm> space,sym,skew;
+    const Workspace& workspace;
+    VectorSpace<DifferentialForm> space,sym;
+    mutable optional<VectorSpace<DifferentialForm>> skew;   //computed when first requested
     ex transpose(ex x) const {
-        matrix m=gl.glToMatrix(x);
-        matrix tm=m.transpose();
-        return gl.MatrixTo_gl(tm);
+        return workspace.transpose(x);
     }
-public:
-    SymmetricAndSkewDecomposition(const GL& gl, const VectorSpace<DifferentialForm>& space) : gl{gl}, space{space} {
+    //the subspace of elements x such that x+sign x^T=0
+    VectorSpace<DifferentialForm> subspace(int sign) const {
         auto x=space.GenericElement();
         auto tx=transpose(x);
-        lst skew_eqns,sym_eqns;
-        GetCoefficients<DifferentialForm>(skew_eqns,x+tx);
-        GetCoefficients<DifferentialForm>(sym_eqns,x-tx);
-        skew=space.SubspaceFromEquations(skew_eqns.begin(),skew_eqns.end());
-        sym=space.SubspaceFromEquations(sym_eqns.begin(),sym_eqns.end());
+        lst eqns;
+        GetCoefficients<DifferentialForm>(eqns,x+sign*tx);
+        return space.SubspaceFromEquations(eqns.begin(),eqns.end());
     }
+public:
+    SymmetricAndSkewDecomposition(const Workspace& workspace, const VectorSpace<DifferentialForm>& space) : workspace{workspace}, space{space}, sym{subspace(-1)} {}
     bool is_direct_sum() const {
-        return space.Dimension()==sym.Dimension()+skew.Dimension();
+        return space.Dimension()==sym.Dimension()+skew_symmetric().Dimension();
     }
     const VectorSpace<DifferentialForm>& symmetric() const {return sym;}
-    const VectorSpace<DifferentialForm>& skew_symmetric() const {return skew;}
+    const VectorSpace<DifferentialForm>& skew_symmetric() const {
+        if (!skew) skew=subspace(1);
+        return skew.value();
+    }
 	const VectorSpace<DifferentialForm>& all() const {return space;}
 };
 
+/** The radical of the Lie algebra of derivations, decomposed as the sum of a maximal torus and the nilradical.
+
+Each component is computed when first requested, so that only the components used by the caller are computed; in particular, the grading only requires the
+symmetric part of the torus, which in turn requires the derivations, the nilradical and the radical, whereas the skew-symmetric part is computed separately.
+*/
 class TorusInDer {
-	friend class GradedDerivations;
-	GL gl;
-	VectorSpace<DifferentialForm> der,n;
-    SymmetricAndSkewDecomposition a;
-	optional<exvector> weights; //real weights, i.e. weight decomposition using real torus
-    exvector imaginary_torus; //basis of the compact torus
+	const LieGroup* G;
+	const StructureConstants* structure_constants;
+	const Workspace& workspace;
+	mutable optional<WeightSpaces> weight_spaces;	//relative to the diagonal derivations; derivations are computed as weight vectors when possible
+	mutable optional<VectorSpace<DifferentialForm>> der_,n_;
+	mutable optional<SymmetricAndSkewDecomposition> a_;
+	mutable optional<optional<exvector>> weights; //real weights, i.e. weight decomposition using real torus
+	const WeightSpaces& gl_weight_spaces() const {
+		if (!weight_spaces) weight_spaces.emplace(diagonal_weights(*structure_constants));
+		return weight_spaces.value();
+	}
+	const VectorSpace<DifferentialForm>& der() const {
+		if (!der_) der_.emplace(derivations_parametric<LieAlgebraParameter>(*G,*structure_constants,linear_group()).basis_of_smaller_space);
+		return der_.value();
+	}
+	const VectorSpace<DifferentialForm>& n() const {
+		if (!n_) n_.emplace(nilradical_of_linear_algebra(der(),workspace,gl_weight_spaces()));
+		return n_.value();
+	}
+	const SymmetricAndSkewDecomposition& a() const {
+		if (!a_) a_.emplace(workspace,torus());
+		return a_.value();
+	}
+	bool characteristically_nilpotent() const {return n().Dimension()==der().Dimension();}
 	VectorSpace<DifferentialForm> torus() const {
-		if (n.Dimension()==der.Dimension()) return {};	//characteristically nilpotent
-		auto r=radical_of_linear_algebra(der,gl);    	
-    	Subspace<DifferentialForm> n_in_r=r.Subspace(n.e().begin(),n.e().end());
+		if (characteristically_nilpotent()) return {};
+		auto r=radical_of_linear_algebra(der(),workspace,gl_weight_spaces());
+    	Subspace<DifferentialForm> n_in_r=r.Subspace(n().e().begin(),n().e().end());
 		return n_in_r.Complement();    	
 	}
     void print_if_nonempty_or(ostream& os, const exvector& l, string label) const {
@@ -103,52 +178,58 @@ class TorusInDer {
         else os<<horizontal(l);
     }
 public:
-	const GL& linear_group() const {return gl;}
-	VectorSpace<DifferentialForm> nilradical() const {return n;}
-	optional<exvector> grading() const {return weights;}
-
-	TorusInDer(const LieGroup& G) : gl(G.Dimension()),der{derivations_parametric<LieAlgebraParameter>(G,gl).basis_of_smaller_space}, n{nilradical_of_linear_algebra(der,gl)}, a{SymmetricAndSkewDecomposition{gl,torus()}} {
-        auto& aR=a.symmetric();
-		auto X=(aR.Dimension()==1? aR.e(1) : aR.GenericElement());
-		auto H=gl.glToMatrix(X);
-		weights=diagonal_elements_if_diagonal_matrix(H);	
+	const GL& linear_group() const {return workspace.gl();}
+	VectorSpace<DifferentialForm> nilradical() const {return n();}
+	optional<exvector> grading() const {
+		if (!weights) {
+			auto& aR=a().symmetric();
+			auto X=(aR.Dimension()==1? aR.e(1) : aR.GenericElement());
+			auto H=linear_group().glToMatrix(X);
+			weights.emplace(diagonal_elements_if_diagonal_matrix(H));
+		}
+		return weights.value();
 	}
+	//true if the torus has been computed
+	bool computed() const {return a_.has_value();}
+
+	TorusInDer(const LieGroup& G, const StructureConstants& structure_constants) : G{&G}, structure_constants{&structure_constants}, workspace{Workspace::of_dimension(G.Dimension())} {}
+	const StructureConstants& constants() const {return *structure_constants;}
 
 	bool is_a_direct_sum() const {
-		return a.is_direct_sum();
+		return a().is_direct_sum();
 	}
 
 	void print(ostream& os) const {
-    	os<<"der ="<<horizontal(der.e())<<endl;		
-		if (n.Dimension()==der.Dimension()) os<<"characteristically nilpotent"<<endl;
+    	os<<"der ="<<horizontal(der().e())<<endl;		
+		if (characteristically_nilpotent()) os<<"characteristically nilpotent"<<endl;
 		else {
-			os<<"n="<<horizontal(n.e())<<endl;
-    		os<<"a_R="<<horizontal(a.symmetric().e())<<endl;			
-    		os<<"a_{iR}="<<horizontal(a.skew_symmetric().e())<<endl;
-            if (!a.is_direct_sum()) os<<"WARNING: a is not a sum of symmetric and skew-symmetric matrices,"<<horizontal(a.all().e())<<endl;
+			os<<"n="<<horizontal(n().e())<<endl;
+    		os<<"a_R="<<horizontal(a().symmetric().e())<<endl;			
+    		os<<"a_{iR}="<<horizontal(a().skew_symmetric().e())<<endl;
+            if (!a().is_direct_sum()) os<<"WARNING: a is not a sum of symmetric and skew-symmetric matrices,"<<horizontal(a().all().e())<<endl;
 		}
-		if (weights) os<<"weights: "<<horizontal(weights.value());
+		if (auto weights=grading()) os<<"weights: "<<horizontal(weights.value());
 		else os<<"canonical basis does not diagonalize a_R"<<endl;
 	}
 	void print_table_row(ostream& os) const {
-		if (n.Dimension()==der.Dimension()) 
+		if (characteristically_nilpotent()) 
 			os<<"characteristically nilpotent";		
 		else {    
-			print_if_nonempty_or(os, a.skew_symmetric().e(),"");
-            if (!a.is_direct_sum()) os<<" (not a sum, "<<horizontal(a.all().e())<<")";
+			print_if_nonempty_or(os, a().skew_symmetric().e(),"");
+            if (!a().is_direct_sum()) os<<" (not a sum, "<<horizontal(a().all().e())<<")";
 		}		
-		if (weights) os<<"&"<<horizontal(weights.value());
-		else os<<"&nondiagonal base; symmetric: "<<horizontal(a.symmetric().e())<<endl;				
+		if (auto weights=grading()) os<<"&"<<horizontal(weights.value());
+		else os<<"&nondiagonal base; symmetric: "<<horizontal(a().symmetric().e())<<endl;				
 	}
 	void print_relations(ostream& os) const {
 		
 	}
 	vector<std::initializer_list<OneBased>> relations() const {
-		auto& weights=this->weights.value();
+		auto weights=grading().value();
 		vector<std::initializer_list<OneBased>> result;
-		for (int i=0;i<gl.n();++i)
-		for (int j=i+1;j<gl.n();++j)
-		for (int k=0;k<gl.n();++k)
+		for (int i=0;i<linear_group().n();++i)
+		for (int j=i+1;j<linear_group().n();++j)
+		for (int k=0;k<linear_group().n();++k)
 			if (weights[i]+weights[j]==weights[k]) result.push_back({k+1,i+1,j+1});
 		return result;
 	}
@@ -156,8 +237,8 @@ public:
 
     vector<matrix> imaginary_derivations_in_torus() const {
         vector<matrix> result;
-        auto convert_to_matrix = [this] (ex x) {return gl.glToMatrix(x);};
-        transform(a.skew_symmetric().e().begin(),a.skew_symmetric().e().end(),back_inserter(result), convert_to_matrix);
+        auto convert_to_matrix = [this] (ex x) {return linear_group().glToMatrix(x);};
+        transform(a().skew_symmetric().e().begin(),a().skew_symmetric().e().end(),back_inserter(result), convert_to_matrix);
         return result;
     }
 
@@ -196,10 +277,11 @@ public:
 
 
 class GradedDerivations {
+	StructureConstants structure_constants;
 	TorusInDer torus;
 	Grading grading;
 public:
-	GradedDerivations(const LieGroup& G) : torus(G), grading{torus.gl,torus.weights.value(),torus.n} {
+	GradedDerivations(const LieGroup& G) : structure_constants{G}, torus(G,structure_constants), grading{torus.linear_group(),torus.grading().value(),torus.nilradical()} {
 		grading.print(cout);	
 	}
 };
\ No newline at end of file
@@ -0,0 +1,294 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include "sweep.h"
+
+/** A directory on a shared filesystem, used to split the computation of a table among processes running on different nodes.
+
+The output of each row is written to a separate file. Rows are grouped in ranges; a process claims a range by creating a lease file atomically,
+and renews the lease by touching it after each row. A lease that has not been renewed for longer than the lease duration is assumed to belong to a
+dead process and can be reclaimed by another one. Each lease file contains the host and pid of its owner, which is checked after creating the lease
+and before renewing or removing it, so that a slow process never removes a lease that has been reclaimed by another one. Since rows are written
+atomically and do not depend on the process computing them, a range computed twice by two processes is harmless. The first process records the table being
+computed in the directory; processes computing a different table are rejected, and each row file records its table, which is checked when merging.
+*/
+class WorkDirectory {
+	using path = std::filesystem::path;
+	path dir;
+	string table;	//identifies the table and the settings its rows depend on
+	string owner;	//host and pid, identifying the process in lease files
+
+	path file(const string& name, int index) const {return dir/(name+"-"+to_string(index));}
+	path row_file(int i) const {return file("row",i);}
+	path lease_file(int first) const {return file("range",first).concat(".lease");}
+	path done_file(int first) const {return file("range",first).concat(".done");}
+	path rows_file() const {return dir/"rows";}
+	path table_file() const {return dir/"table";}
+
+	bool create_exclusively(const path& p) const {
+		int fd=open(p.c_str(),O_CREAT|O_EXCL|O_WRONLY,0644);
+		if (fd<0) {
+			if (errno==EEXIST) return false;
+			throw std::runtime_error("cannot create "+p.string()+": "+strerror(errno));
+		}
+		fdio::write_fully(fd,owner.data(),owner.size());
+		close(fd);
+		return true;
+	}
+	//write a file atomically, so that other processes never see it partially written
+	void write_file(const path& p, const string& contents) const {
+		auto temporary=p;
+		temporary+="."+owner+".tmp";
+		{
+			std::ofstream os{temporary,std::ios::binary};
+			os<<contents;
+			if (!os) throw std::runtime_error("cannot write "+temporary.string());
+		}
+		std::filesystem::rename(temporary,p);
+	}
+	//create a file with the given contents atomically, unless it exists already
+	void write_file_unless_exists(const path& p, const string& contents) const {
+		auto temporary=p;
+		temporary+="."+owner+".tmp";
+		write_file(temporary,contents);
+		std::error_code error;
+		std::filesystem::create_hard_link(temporary,p,error);	//fails if p exists
+		std::filesystem::remove(temporary,error);
+	}
+	void check_table() const {
+		auto recorded=read_file(table_file());
+		if (recorded!=table) throw std::invalid_argument("work directory "+dir.string()+" contains the table \""+recorded+"\", not \""+table+"\"");
+	}
+	string read_file(const path& p) const {
+		std::ifstream is{p,std::ios::binary};
+		if (!is) throw std::runtime_error("cannot read "+p.string());
+		stringstream s;
+		s<<is.rdbuf();
+		return s.str();
+	}
+	//the owner recorded in a lease file, or nullopt if the file does not exist
+	static optional<string> owner_of(const path& p) {
+		std::ifstream is{p,std::ios::binary};
+		if (!is) return nullopt;
+		stringstream s;
+		s<<is.rdbuf();
+		return s.str();
+	}
+	bool expired(const path& p, std::chrono::seconds lease) const {
+		std::error_code error;
+		auto last_renewal=std::filesystem::last_write_time(p,error);
+		return !error && std::filesystem::file_time_type::clock::now()-last_renewal>=lease;
+	}
+	bool owns(const path& p) const {return owner_of(p)==owner;}
+	//move a lease file that turns out to belong to another process back in place, unless it has been replaced meanwhile
+	static void put_back(const path& moved, const path& p) {
+		std::error_code error;
+		std::filesystem::create_hard_link(moved,p,error);
+		std::filesystem::remove(moved,error);
+	}
+public:
+/** Open a work directory to compute a table, creating it if it does not exist
+
+ @param dir The directory
+ @param table A string identifying the table and the settings its rows depend on; processes computing a different table in the same directory are rejected
+*/
+	WorkDirectory(const string& dir, const string& table) : dir{dir}, table{table}, owner{fdio::host_and_pid()} {
+		std::filesystem::create_directories(this->dir);
+	}
+	//open an existing work directory, e.g. to merge its rows, taking the table from the directory
+	explicit WorkDirectory(const string& dir) : dir{dir}, owner{fdio::host_and_pid()} {
+		if (!std::filesystem::is_directory(this->dir)) throw std::invalid_argument("work directory "+dir+" does not exist");
+		if (!std::filesystem::exists(table_file())) throw std::invalid_argument("work directory "+dir+" does not contain a table");
+		table=read_file(table_file());
+	}
+	const string& table_key() const {return table;}
+	//record the table and its number of rows, or check them against those recorded by another process
+	void set_table(int rows) const {
+		write_file_unless_exists(table_file(),table);
+		check_table();
+		if (std::filesystem::exists(rows_file()) && number_of_rows()!=rows)
+			throw std::invalid_argument("work directory "+dir.string()+" contains a table with "+to_string(number_of_rows())+" rows, not "+to_string(rows));
+		write_file(rows_file(),to_string(rows));
+	}
+	int number_of_rows() const {
+		return stoi(read_file(rows_file()));
+	}
+	bool has_row(int i) const {return std::filesystem::exists(row_file(i));}
+	//rows are stored after a line containing the table, so that rows of different tables are never mixed
+	void write_row(int i, const string& output) const {write_file(row_file(i),table+"\n"+output);}
+	string read_row(int i) const {
+		auto contents=read_file(row_file(i));
+		auto end_of_table=contents.find('\n');
+		if (end_of_table==string::npos || contents.substr(0,end_of_table)!=table)
+			throw std::invalid_argument("row "+to_string(i+1)+" in work directory "+dir.string()+" does not belong to the table \""+table+"\"");
+		return contents.substr(end_of_table+1);
+	}
+
+	bool is_done(int first) const {return std::filesystem::exists(done_file(first));}
+	void mark_done(int first) const {
+		create_exclusively(done_file(first));
+		release(first);
+	}
+	//return true if the range starting at first has been claimed by this process
+	bool try_claim(int first, std::chrono::seconds lease) const {
+		check_table();
+		auto p=lease_file(first);
+		if (create_exclusively(p)) return owns(p);
+		auto expired_owner=owner_of(p);
+		if (!expired_owner || !expired(p,lease)) return false;	//the lease is held, or has just been released or reclaimed
+		auto stale=p;
+		stale+=".stale."+owner;
+		std::error_code error;
+		std::filesystem::rename(p,stale,error);
+		if (error) return false;
+		//another process may have reclaimed the lease after we checked it, in which case we have moved its fresh lease
+		if (owner_of(stale)!=expired_owner || !expired(stale,lease)) {
+			put_back(stale,p);
+			return false;
+		}
+		std::filesystem::remove(stale,error);
+		cerr<<"reclaiming expired lease "<<p<<endl;
+		return create_exclusively(p) && owns(p);
+	}
+	void renew(int first) const {
+		auto p=lease_file(first);
+		if (!owns(p)) return;
+		std::error_code error;
+		std::filesystem::last_write_time(p,std::filesystem::file_time_type::clock::now(),error);
+	}
+	//remove the lease, unless it has been reclaimed by another process
+	void release(int first) const {
+		auto p=lease_file(first);
+		auto released=p;
+		released+=".released."+owner;
+		std::error_code error;
+		std::filesystem::rename(p,released,error);	//take the lease out of place first, so that it cannot be reclaimed between the check and the removal
+		if (error) return;
+		if (owner_of(released)==owner) std::filesystem::remove(released,error);
+		else put_back(released,p);
+	}
+};
+
+/** Hands out the rows of a table stored in a WorkDirectory, claiming one range at a time */
+class LeaseQueue {
+	const WorkDirectory& work_dir;
+	int rows;
+	int rows_per_range;
+	std::chrono::seconds lease;
+	struct ClaimedRange {
+		int next;
+		int end;
+		int outstanding;	//rows handed out whose output has not been written yet
+	};
+	map<int,ClaimedRange> claimed;
+	int current=-1;		//first row of the range rows are being handed out from, or -1
+	vector<bool> known_done;
+
+	int range_of(int i) const {return i-i%rows_per_range;}
+	optional<int> claim_next_range() {
+		for (int first=0;first<rows;first+=rows_per_range) {
+			if (known_done[first/rows_per_range] || claimed.count(first)) continue;
+			if (work_dir.is_done(first)) known_done[first/rows_per_range]=true;
+			else if (work_dir.try_claim(first,lease)) return first;
+		}
+		return nullopt;
+	}
+	void finish_if_complete(int first) {
+		auto& range=claimed.at(first);
+		if (range.next<range.end || range.outstanding) return;
+		work_dir.mark_done(first);
+		known_done[first/rows_per_range]=true;
+		claimed.erase(first);
+	}
+public:
+	LeaseQueue(const WorkDirectory& work_dir, int rows, std::chrono::seconds lease, int rows_per_range=8) :
+		work_dir{work_dir}, rows{rows}, rows_per_range{rows_per_range}, lease{lease}, known_done((rows+rows_per_range-1)/rows_per_range) {}
+	optional<int> next_row() {
+		while (true) {
+			if (current>=0) {
+				auto& range=claimed.at(current);
+				while (range.next<range.end && work_dir.has_row(range.next)) ++range.next;	//rows written by a previous owner of the lease
+				if (range.next<range.end) {
+					++range.outstanding;
+					return range.next++;
+				}
+				finish_if_complete(current);
+				current=-1;
+			}
+			auto first=claim_next_range();
+			if (!first) return nullopt;
+			current=first.value();
+			claimed[current]=ClaimedRange{current,min(current+rows_per_range,rows),0};
+		}
+	}
+	void row_done(int i, const string& output) {
+		work_dir.write_row(i,output);
+		auto first=range_of(i);
+		work_dir.renew(first);
+		--claimed.at(first).outstanding;
+		if (first!=current) finish_if_complete(first);
+	}
+	bool all_done() {
+		for (int first=0;first<rows;first+=rows_per_range)
+			if (!known_done[first/rows_per_range]) {
+				if (!work_dir.is_done(first)) return false;
+				known_done[first/rows_per_range]=true;
+			}
+		return true;
+	}
+};
+
+/** Compute the rows of a table in a work directory shared with other processes, until all rows have been computed
+
+@param work_dir The shared work directory
+@param rows The number of rows
+@param print_row A function printing the i-th row on a stream
+@param print_out_of_budget_row A function printing the i-th row on a stream when its computation exceeds the budget
+@param sweep Parameters determining the number of worker processes used by this process and the budget for each row; rows are not retried with a larger budget
+@param format A stream whose formatting flags are used to print the rows
+@param lease Time after which a range claimed by a process that has not written any row is reclaimed
+*/
+void compute_rows_in_work_directory(const WorkDirectory& work_dir, int rows, const function<void(int,ostream&)>& print_row, const function<void(int,ostream&)>& print_out_of_budget_row, const SweepParameters& sweep, const ostream& format, std::chrono::seconds lease) {
+	work_dir.set_table(rows);
+	LeaseQueue queue{work_dir,rows,lease};
+	auto next_row=[&queue] () {return queue.next_row();};
+	auto row_done=[&queue,&print_out_of_budget_row,&format] (int i, bool out_of_budget, string&& output) {
+		if (out_of_budget) {
+			stringstream s;
+			s.copyfmt(format);
+			print_out_of_budget_row(i,s);
+			output=s.str();
+		}
+		queue.row_done(i,output);
+	};
+	while (true) {
+		compute_rows(next_row,print_row,row_done,sweep.jobs,format,sweep.budget);
+		if (queue.all_done()) break;
+		//the remaining ranges are claimed by other processes; wait in case one of them dies
+		std::this_thread::sleep_for(min(lease/4,std::chrono::seconds{60}));
+	}
+}
+
+//print the table whose rows have been computed in a work directory
+void merge_work_directory(const WorkDirectory& work_dir, ostream& os) {
+	cerr<<"merging table "<<work_dir.table_key()<<endl;
+	int rows=work_dir.number_of_rows();
+	int missing=0;
+	os<<"%\\begin{array}{ccc}"<<endl;
+	for (int i=0;i<rows;++i)
+		if (work_dir.has_row(i)) os<<work_dir.read_row(i);
+		else {
+			cerr<<"row "<<i+1<<" has not been computed"<<endl;
+			++missing;
+		}
+	os<<"%\\end{array}"<<endl;
+	if (missing) cerr<<missing<<" of "<<rows<<" rows missing"<<endl;
+}
+
+#endif
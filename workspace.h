@@ -0,0 +1,70 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <memory>
+#include <tuple>
+
+/** The objects that only depend on the dimension n of a Lie algebra, computed once and shared by all the Lie algebras of the same dimension.
+
+These are the Lie algebra gl(n) with its basis, the trace form tr(XY) and the transpose on gl(n), expressed relative to the basis, and the involutions of the
+basis of R^n together with the corresponding sigma-diagonal metrics. Workspaces are created when first requested; when computing a table, the workspace is
+created before the rows are distributed among worker processes, so that it is computed only once.
+*/
+class Workspace {
+	GL gl_;
+	exvector basis;								//the basis of gl(n)
+	vector<tuple<int,int,ex>> trace_form_;		//the nonzero entries (s,t,tr(e_se_t)) of the Gram matrix of the trace form relative to the basis
+	exmap transpose_;							//maps each element of the basis to its transpose
+	vector<vector<int>> involutions_;
+	vector<matrix> sigma_diagonal_metrics_;
+
+	exvector coordinates(ex gl_element) const {
+		gl_element=gl_element.expand();
+		exvector result;
+		for (auto& e: basis) result.push_back(gl_element.coeff(e));
+		return result;
+	}
+	Workspace(int n) : gl_(n), basis{gl_.pForms(1).e()} {
+		vector<matrix> matrices;
+		for (auto& e: basis) matrices.push_back(gl_.glToMatrix(e));
+		for (int s=0;s<basis.size();++s)
+		for (int t=0;t<basis.size();++t) {
+			ex trace;
+			for (int i=0;i<n;++i)
+			for (int j=0;j<n;++j)
+				trace+=matrices[s](i,j)*matrices[t](j,i);
+			if (!trace.is_zero()) trace_form_.emplace_back(s,t,trace);
+		}
+		for (int s=0;s<basis.size();++s) {
+			matrix transpose=matrices[s].transpose();
+			transpose_[basis[s]]=gl_.MatrixTo_gl(transpose);
+		}
+		auto all_metrics=SigmaDiagonalMetrics{n};
+		for (auto g=all_metrics.begin();g!=all_metrics.end();++g) {
+			sigma_diagonal_metrics_.push_back(*g);
+			involutions_.push_back(g.automorphism().as_permutation());
+		}
+	}
+public:
+	static const Workspace& of_dimension(int n) {
+		static map<int,unique_ptr<Workspace>> workspaces;
+		auto& workspace=workspaces[n];
+		if (!workspace) workspace.reset(new Workspace{n});
+		return *workspace;
+	}
+	const GL& gl() const {return gl_;}
+	//the trace of XY, where X and Y are the matrices of the two elements of gl(n)
+	ex tr_product(ex gl_element1, ex gl_element2) const {
+		auto x=coordinates(gl_element1), y=coordinates(gl_element2);
+		ex result;
+		for (auto& entry: trace_form_) result+=x[get<0>(entry)]*y[get<1>(entry)]*get<2>(entry);
+		return result.expand();
+	}
+	ex transpose(ex gl_element) const {return gl_element.subs(transpose_);}
+	//the sigma-diagonal metrics, in the order of SigmaDiagonalMetrics
+	const vector<matrix>& sigma_diagonal_metrics() const {return sigma_diagonal_metrics_;}
+	//the involutions sigma corresponding to each sigma-diagonal metric, as permutations
+	const vector<vector<int>>& involutions() const {return involutions_;}
+};
+
+#endif